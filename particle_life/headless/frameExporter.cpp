@@ -0,0 +1,236 @@
+#include "frameExporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <zlib.h>
+
+/**
+ * @brief PNG file written band by band, RGB with 8 bits per channel
+ *
+ * The rows are compressed as they arrive into IDAT chunks, the alpha of the bands is dropped.
+ */
+class pngStream
+{
+public:
+	~pngStream()
+	{
+		if (started) deflateEnd(&stream);
+		if (file != nullptr) std::fclose(file);
+	}
+
+	bool open(const std::string& path, const int width, const int height)
+	{
+		file = std::fopen(path.c_str(), "wb");
+		if (file == nullptr) return false;
+		columns = width;
+		row.resize(1 + static_cast<size_t>(width) * 3);
+		output.resize(1 << 16);
+		std::memset(&stream, 0, sizeof(stream));
+		if (deflateInit(&stream, Z_BEST_SPEED) != Z_OK) return false;
+		started = true;
+
+		static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		uint8_t header[13] = {};
+		store(header, static_cast<uint32_t>(width));
+		store(header + 4, static_cast<uint32_t>(height));
+		header[8] = 8;	// bits per channel
+		header[9] = 2;	// RGB
+		return std::fwrite(signature, 1, sizeof(signature), file) == sizeof(signature) && chunk("IHDR", header, sizeof(header));
+	}
+
+	// append RGBA rows, without a filter
+	bool rows(const uint8_t* pixels, const int count)
+	{
+		for (auto y = 0; y < count; y++)
+		{
+			const uint8_t* source = pixels + static_cast<size_t>(y) * columns * 4;
+			row[0] = 0;
+			for (auto x = 0; x < columns; x++)
+			{
+				row[1 + 3 * x] = source[4 * x];
+				row[2 + 3 * x] = source[4 * x + 1];
+				row[3 + 3 * x] = source[4 * x + 2];
+			}
+			if (!compress(row.data(), row.size(), Z_NO_FLUSH)) return false;
+		}
+		return true;
+	}
+
+	// end of the image, false when the file could not be written
+	bool finish()
+	{
+		if (!compress(nullptr, 0, Z_FINISH) || !chunk("IEND", nullptr, 0)) return false;
+		const bool closed = std::fclose(file) == 0;
+		file = nullptr;
+		return closed;
+	}
+
+private:
+	static void store(uint8_t* bytes, const uint32_t value)
+	{
+		bytes[0] = static_cast<uint8_t>(value >> 24);
+		bytes[1] = static_cast<uint8_t>(value >> 16);
+		bytes[2] = static_cast<uint8_t>(value >> 8);
+		bytes[3] = static_cast<uint8_t>(value);
+	}
+
+	bool chunk(const char* type, const uint8_t* data, const size_t size)
+	{
+		uint8_t length[4];
+		uint8_t crc[4];
+		store(length, static_cast<uint32_t>(size));
+		uLong sum = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+		if (size > 0) sum = crc32(sum, data, static_cast<uInt>(size));
+		store(crc, static_cast<uint32_t>(sum));
+		return std::fwrite(length, 1, 4, file) == 4 && std::fwrite(type, 1, 4, file) == 4 && (size == 0 || std::fwrite(data, 1, size, file) == size) &&
+			std::fwrite(crc, 1, 4, file) == 4;
+	}
+
+	// feed the compressor, every full output buffer becomes a chunk
+	bool compress(const uint8_t* data, const size_t size, const int flush)
+	{
+		stream.next_in = const_cast<Bytef*>(data);
+		stream.avail_in = static_cast<uInt>(size);
+		int status;
+		do
+		{
+			stream.next_out = output.data();
+			stream.avail_out = static_cast<uInt>(output.size());
+			status = deflate(&stream, flush);
+			if (status == Z_STREAM_ERROR) return false;
+			const size_t produced = output.size() - stream.avail_out;
+			if (produced > 0 && !chunk("IDAT", output.data(), produced)) return false;
+		} while (stream.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+		return true;
+	}
+
+	std::FILE* file = nullptr;
+	z_stream stream;
+	bool started = false;
+	int columns = 0;
+	std::vector<uint8_t> row;		// filter byte and RGB
+	std::vector<uint8_t> output;
+};
+
+frameExporter::frameExporter(const options& exportSettings) :
+	settings(exportSettings),
+	renderer(exportSettings.threads > 0 ? exportSettings.threads : std::max(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1)),
+	slots(EXPORT_QUEUE)
+{
+	for (auto i = 0; i < EXPORT_QUEUE; i++) idle.push_back(i);
+	writer = std::thread(&frameExporter::loop, this);
+}
+
+frameExporter::~frameExporter()
+{
+	close();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	changed.notify_all();
+	writer.join();
+}
+
+bool frameExporter::open(const std::string& model)
+{
+	close();
+	name = model;
+	frames = 0;
+	failed = false;
+	waitedMs = 0.0;
+	if (!settings.video) return true;
+	video = std::fopen((settings.directory + "/" + name + ".rgba").c_str(), "wb");
+	return video != nullptr;
+}
+
+void frameExporter::submit(const simulation& world, const simulationParams& params, const int step)
+{
+	int slot;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (idle.empty())
+		{
+			const auto begin = std::chrono::steady_clock::now();
+			changed.wait(lock, [this] { return !idle.empty(); });
+			waitedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		}
+		slot = idle.back();
+		idle.pop_back();
+	}
+
+	// the only work of the simulation thread: copies into buffers that keep their capacity
+	frame& picture = slots[slot];
+	picture.particles.x = world.particles.x;
+	picture.particles.y = world.particles.y;
+	picture.particles.start = world.particles.start;
+	picture.particles.color = world.particles.color;
+	picture.active = params.active;
+	picture.canvasWidth = static_cast<float>(params.width);
+	picture.canvasHeight = static_cast<float>(params.height);
+	picture.step = step;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.push_back(slot);
+	}
+	changed.notify_all();
+}
+
+bool frameExporter::close()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this] { return pending.empty() && !writing; });
+	}
+	if (video != nullptr)
+	{
+		if (std::fclose(video) != 0) failed = true;
+		video = nullptr;
+	}
+	return !failed;
+}
+
+void frameExporter::loop()
+{
+	for (;;)
+	{
+		int slot;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [this] { return stopping || !pending.empty(); });
+			if (pending.empty()) return;
+			slot = pending.front();
+			pending.pop_front();
+			writing = true;
+		}
+
+		const bool done = write(slots[slot]);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (done) frames++;
+			else failed = true;
+			idle.push_back(slot);
+			writing = false;
+		}
+		changed.notify_all();
+	}
+}
+
+bool frameExporter::write(const frame& picture)
+{
+	if (settings.video)
+	{
+		const size_t rowBytes = static_cast<size_t>(settings.width) * 4;
+		return video != nullptr && renderer.render(picture.particles, picture.active, picture.canvasWidth, picture.canvasHeight, settings.width, settings.height,
+			[this, rowBytes](const uint8_t* rows, int, const int count) { return std::fwrite(rows, rowBytes, count, video) == static_cast<size_t>(count); });
+	}
+
+	char step[16];
+	std::snprintf(step, sizeof(step), "%06d", picture.step);
+	pngStream png;
+	return png.open(settings.directory + "/" + name + "_" + step + ".png", settings.width, settings.height) &&
+		renderer.render(picture.particles, picture.active, picture.canvasWidth, picture.canvasHeight, settings.width, settings.height,
+			[&png](const uint8_t* rows, int, const int count) { return png.rows(rows, count); }) &&
+		png.finish();
+}
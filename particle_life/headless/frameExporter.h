@@ -0,0 +1,99 @@
+#pragma once
+
+#include "simulation.h"
+#include "splatRenderer.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Pictures of the runs of the headless runner, drawn by the splat renderer and written on their own thread.
+ * submit() only copies the positions of a step into a free frame and returns: the rasterizer and the
+ * encoder run on the writer thread and the threads of the renderer while the simulation steps on. Up to
+ * EXPORT_QUEUE frames wait to be written. When they are all taken the simulation waits for the writer: the
+ * backpressure is deliberate, a video with holes is worth less than a slower run, so no frame is ever
+ * dropped. The runner gives the renderer and the step their own share of the cores by default, so that
+ * they do not compete. A frame is written as a PNG file, or appended to a raw RGBA video that tools like
+ * ffmpeg read with -f rawvideo -pix_fmt rgba -s WxH. Both are written band by band as they are drawn.
+ */
+
+#define EXPORT_QUEUE 3 // frames waiting for the writer
+
+class frameExporter
+{
+public:
+	struct options
+	{
+		std::string directory;	// where the files are written
+		int width = 0;			// size of the frames in pixels
+		int height = 0;
+		bool video = false;		// one raw video per model instead of one PNG file per frame
+		int threads = 0;		// threads of the renderer, 0 for half the cores
+	};
+
+	explicit frameExporter(const options& settings);
+	~frameExporter();
+
+	frameExporter(const frameExporter&) = delete;
+	frameExporter& operator=(const frameExporter&) = delete;
+
+	/**
+	 * @brief Start the frames of a model
+	 *
+	 * @param name name of the model, prefix of the files
+	 * @return false when the video cannot be created
+	 */
+	bool open(const std::string& name);
+
+	/**
+	 * @brief Queue the positions of a step, waiting only when EXPORT_QUEUE frames are already queued
+	 */
+	void submit(const simulation& world, const simulationParams& params, int step);
+
+	/**
+	 * @brief Write the queued frames and close the video
+	 *
+	 * @return false when a frame could not be written
+	 */
+	bool close();
+
+	int written() const { return frames; }					// frames of the model written so far
+	double waited() const { return waitedMs; }				// time submit() spent waiting for the writer
+
+private:
+	struct frame
+	{
+		particleBuffer particles;	// positions, groups and colors only
+		std::vector<bool> active;
+		float canvasWidth = 0.0F;
+		float canvasHeight = 0.0F;
+		int step = 0;
+	};
+
+	void loop();
+
+	// draw a frame and write it, on the writer thread
+	bool write(const frame& picture);
+
+	options settings;
+	splatRenderer renderer;
+	std::string name;
+	std::FILE* video = nullptr;
+	int frames = 0;
+	bool failed = false;
+	double waitedMs = 0.0;
+
+	std::vector<frame> slots;
+	std::vector<int> idle;		// slots the simulation can fill
+	std::deque<int> pending;	// slots waiting for the writer, oldest first
+	bool writing = false;		// the writer holds a slot
+	bool stopping = false;
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::thread writer;
+};
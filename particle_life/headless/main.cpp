@@ -0,0 +1,303 @@
+#include "simulation.h"
+#include "model.h"
+#include "simd.h"
+#include "frameExporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Headless runner: steps saved models without a window and prints statistics, for batch runs on
+ * machines without a GPU. Each model given on the command line is run in turn with the same options.
+ */
+
+struct runOptions
+{
+	int steps = 1000;
+	int threads = 0;
+	int every = 0;			// steps between two statistics lines, 0 for the last step only
+	int types = 0;			// groups of the runs, 0 for the groups of the models
+	float falloff = 0.0F;	// force profile of every pair
+	float core = 0.0F;
+	float mass = 1.0F;		// mass of every group
+	uint64_t seed = 1;
+	std::string stateDir;	// where the final particles are written, none when empty
+	std::string frameDir;	// where the pictures are written, none when empty
+	int frameEvery = 0;		// steps between two pictures, 0 for the last step only
+	frameExporter::options frames;
+	simulationParams params;
+};
+
+static void usage()
+{
+	std::fprintf(stderr,
+		"usage: particle_life_headless [options] model...\n"
+		"  --steps N         steps per model (1000)\n"
+		"  --threads N       threads of the step, 0 for one per core, or the cores left to it by the pictures (0)\n"
+		"  --size WxH        canvas size (1920x1080)\n"
+		"  --seed N          seed of the positions, colors and probability draws (1)\n"
+		"  --types N         run with N groups, up to 32: the groups past the model get random relations\n"
+		"  --every N         print the statistics every N steps (last step only)\n"
+		"  --state DIR       write the final particles of each model to DIR/<model>.csv\n"
+		"  --infinite        infinite radius, through the quadtrees\n"
+		"  --verlet          Verlet lists instead of the grid\n"
+		"  --skin S          margin of the Verlet lists, 0 to follow the speed of the particles (0)\n"
+		"  --periodic        forces wrap around the canvas\n"
+		"  --unbounded       positions do not wrap around the canvas\n"
+		"  --gravity G       world gravity (0)\n"
+		"  --falloff F       decay of the attraction over the radius, as (1 - d / radius)^F (0)\n"
+		"  --core C          share of the radius with a repulsive core (0)\n"
+		"  --wall-repel R    wall repel distance (20)\n"
+		"  --mass-gravity G  gravity of the masses, of infinite range, through the particle mesh (0)\n"
+		"  --mass M          mass of every particle, negative for antigravity (1)\n"
+		"  --mesh N          cells per side of the particle mesh, a power of 2 (128)\n"
+		"  --frames DIR      draw the particles to DIR/<model>_<step>.png\n"
+		"  --frame-every N   steps between two pictures (last step only)\n"
+		"  --frame-size WxH  size of the pictures, the canvas is scaled onto them (canvas size)\n"
+		"  --video           append the pictures to the raw RGBA video DIR/<model>.rgba instead\n"
+		"  --render-threads N  threads drawing the pictures, 0 for half the cores (0)\n");
+}
+
+/**
+ * @brief Mean speed and mean kinetic energy of the active particles
+ */
+static void motion(const simulation& world, const simulationParams& params, double& speed, double& energy)
+{
+	double speedSum = 0.0;
+	double energySum = 0.0;
+	size_t n = 0;
+	const particleBuffer& particles = world.particles;
+	for (auto t = 0; t < world.types(); t++)
+	{
+		if (!params.active[t]) continue;
+		for (auto i = particles.start[t]; i < particles.start[t + 1]; i++)
+		{
+			const double v2 = static_cast<double>(particles.vx[i]) * particles.vx[i] + static_cast<double>(particles.vy[i]) * particles.vy[i];
+			speedSum += std::sqrt(v2);
+			energySum += 0.5 * v2;
+		}
+		n += particles.count(t);
+	}
+	speed = n > 0 ? speedSum / n : 0.0;
+	energy = n > 0 ? energySum / n : 0.0;
+}
+
+/**
+ * @brief Write the particles of the active groups, one line per particle
+ *
+ * With the mass gravity on, the field at each particle and the stretch of its tidal tensor follow.
+ */
+static bool writeState(const std::string& path, const simulation& world, const simulationParams& params)
+{
+	std::ofstream file(path);
+	if (!file.is_open()) return false;
+	const bool mesh = params.massGravity != 0.0F && world.field.size() == world.particles.size();
+	file << (mesh ? "type,id,x,y,vx,vy,gx,gy,tide\n" : "type,id,x,y,vx,vy\n");
+	const particleBuffer& particles = world.particles;
+	for (auto t = 0; t < world.types(); t++)
+	{
+		if (!params.active[t]) continue;
+		for (auto i = particles.start[t]; i < particles.start[t + 1]; i++)
+		{
+			file << t << ',' << particles.id[i] << ',' << particles.x[i] << ',' << particles.y[i] << ',' << particles.vx[i] << ',' << particles.vy[i];
+			if (mesh) file << ',' << world.field[i].gx << ',' << world.field[i].gy << ',' << world.field[i].stretch();
+			file << '\n';
+		}
+	}
+	return static_cast<bool>(file);
+}
+
+/**
+ * @brief Run one model and print its statistics
+ *
+ * @return false when the model cannot be read or the state cannot be written
+ */
+static bool run(const std::string& path, simulation& world, const runOptions& options, frameExporter* exporter)
+{
+	simulationModel model;
+	if (!loadModel(path, model))
+	{
+		std::fprintf(stderr, "%s: not a model file (%d numbers expected)\n", path.c_str(), MODEL_SIZE);
+		return false;
+	}
+
+	// the extra groups are drawn from the seed, with the default variances of the interface
+	if (options.types > 0 && options.types != model.types())
+	{
+		std::mt19937 rng(static_cast<uint32_t>(options.seed));
+		resizeModel(model, options.types, rng, 0.7F, 0.5F);
+	}
+
+	simulationParams params = options.params;
+	params.resize(model.types());
+	params.matrix = model.matrix;
+	std::fill(params.matrix.falloff.values.begin(), params.matrix.falloff.values.end(), options.falloff);
+	std::fill(params.matrix.core.values.begin(), params.matrix.core.values.end(), options.core);
+	std::fill(params.mass.begin(), params.mass.end(), options.mass);
+	for (auto t = 0; t < model.types(); t++) params.active[t] = model.count[t] > 0;
+	world.restart(model.count.data(), model.types(), params.width, params.height, options.seed);
+
+	const std::string name = path.substr(path.find_last_of("/\\") + 1);
+	if (exporter != nullptr && !exporter->open(name))
+	{
+		std::fprintf(stderr, "%s: unable to create the video in %s\n", name.c_str(), options.frameDir.c_str());
+		return false;
+	}
+	const int every = options.every > 0 ? options.every : options.steps;
+	const int frameEvery = options.frameEvery > 0 ? options.frameEvery : options.steps;
+	int firstBuilds = world.listBuilds();
+	auto begin = std::chrono::steady_clock::now();
+	double exported = 0.0;	// time spent handing the frames over, left out of the step time
+	for (auto step = 1; step <= options.steps; step++)
+	{
+		world.step(params);
+		if (exporter != nullptr && (step % frameEvery == 0 || step == options.steps))
+		{
+			const auto queued = std::chrono::steady_clock::now();
+			exporter->submit(world, params, step);
+			exported += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - queued).count();
+		}
+		if (step % every != 0 && step != options.steps) continue;
+
+		const auto end = std::chrono::steady_clock::now();
+		const int done = step % every != 0 ? step % every : every;
+		const double ms = (std::chrono::duration<double, std::milli>(end - begin).count() - exported) / done;
+		double speed;
+		double energy;
+		motion(world, params, speed, energy);
+		std::printf("%s\t%d\t%.3f\t%.1f\t%.4f\t%.4f\t%s\t%s\n", name.c_str(), step, ms, ms > 0.0 ? 1000.0 / ms : 0.0, speed, energy,
+			params.infinite ? std::to_string(world.treeError).c_str() : "-",
+			params.verlet && !params.infinite ? std::to_string(world.listBuilds() - firstBuilds).c_str() : "-");
+		std::fflush(stdout);
+		firstBuilds = world.listBuilds();
+		exported = 0.0;
+		begin = std::chrono::steady_clock::now();
+	}
+	std::fprintf(stderr, "%s: %d pair traversals\n", name.c_str(), world.traversals());
+	if (exporter != nullptr)
+	{
+		const bool written = exporter->close();
+		std::fprintf(stderr, "%s: %d pictures, the steps waited %.1f ms for them, not counted in their time\n", name.c_str(), exporter->written(), exporter->waited());
+		if (!written)
+		{
+			std::fprintf(stderr, "%s: unable to write the pictures to %s\n", name.c_str(), options.frameDir.c_str());
+			return false;
+		}
+	}
+
+	if (!options.stateDir.empty())
+	{
+		const std::string file = options.stateDir + "/" + name + ".csv";
+		if (!writeState(file, world, params))
+		{
+			std::fprintf(stderr, "%s: unable to write the state\n", file.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	runOptions options;
+	options.params.width = 1920;
+	options.params.height = 1080;
+	std::vector<std::string> models;
+
+	for (auto i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--steps" && hasValue) options.steps = std::atoi(argv[++i]);
+		else if (arg == "--threads" && hasValue) options.threads = std::atoi(argv[++i]);
+		else if (arg == "--every" && hasValue) options.every = std::atoi(argv[++i]);
+		else if (arg == "--seed" && hasValue) options.seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--types" && hasValue) options.types = std::atoi(argv[++i]);
+		else if (arg == "--state" && hasValue) options.stateDir = argv[++i];
+		else if (arg == "--frames" && hasValue) options.frameDir = argv[++i];
+		else if (arg == "--frame-every" && hasValue) options.frameEvery = std::atoi(argv[++i]);
+		else if (arg == "--render-threads" && hasValue) options.frames.threads = std::atoi(argv[++i]);
+		else if (arg == "--gravity" && hasValue) options.params.gravity = static_cast<float>(std::atof(argv[++i]));
+		else if (arg == "--falloff" && hasValue) options.falloff = static_cast<float>(std::atof(argv[++i]));
+		else if (arg == "--core" && hasValue) options.core = static_cast<float>(std::atof(argv[++i]));
+		else if (arg == "--mass-gravity" && hasValue) options.params.massGravity = static_cast<float>(std::atof(argv[++i]));
+		else if (arg == "--mass" && hasValue) options.mass = static_cast<float>(std::atof(argv[++i]));
+		else if (arg == "--mesh" && hasValue) options.params.meshSize = std::atoi(argv[++i]);
+		else if (arg == "--wall-repel" && hasValue) options.params.wallRepel = static_cast<float>(std::atof(argv[++i]));
+		else if (arg == "--size" && hasValue)
+		{
+			if (std::sscanf(argv[++i], "%dx%d", &options.params.width, &options.params.height) != 2)
+			{
+				usage();
+				return 2;
+			}
+		}
+		else if (arg == "--frame-size" && hasValue)
+		{
+			if (std::sscanf(argv[++i], "%dx%d", &options.frames.width, &options.frames.height) != 2 || options.frames.width <= 0 || options.frames.height <= 0)
+			{
+				usage();
+				return 2;
+			}
+		}
+		else if (arg == "--video") options.frames.video = true;
+		else if (arg == "--infinite") options.params.infinite = true;
+		else if (arg == "--verlet") options.params.verlet = true;
+		else if (arg == "--skin" && hasValue) options.params.skin = static_cast<float>(std::atof(argv[++i]));
+		else if (arg == "--periodic") options.params.periodic = true;
+		else if (arg == "--unbounded") options.params.bounded = false;
+		else if (arg == "--help" || arg == "-h")
+		{
+			usage();
+			return 0;
+		}
+		else if (arg.compare(0, 2, "--") == 0)
+		{
+			usage();
+			return 2;
+		}
+		else models.push_back(arg);
+	}
+	if (models.empty() || options.steps <= 0 || options.params.width <= 0 || options.params.height <= 0 || options.types < 0 || options.types > TYPE_MAX)
+	{
+		usage();
+		return 2;
+	}
+
+	// with pictures the cores are split between the step and the renderer, so that they do not compete:
+	// the step still waits for the writer when EXPORT_QUEUE frames are queued, no picture is ever dropped
+	std::unique_ptr<frameExporter> exporter;
+	if (!options.frameDir.empty())
+	{
+		const int cores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+		if (options.frames.threads <= 0) options.frames.threads = std::max(cores / 2, 1);
+		if (options.threads <= 0) options.threads = std::max(cores - options.frames.threads, 1);
+		if (options.frames.width == 0)
+		{
+			options.frames.width = options.params.width;
+			options.frames.height = options.params.height;
+		}
+		options.frames.directory = options.frameDir;
+		exporter.reset(new frameExporter(options.frames));
+	}
+	simulation world(options.threads);
+	std::fprintf(stderr, "%d threads, %s kernels\n", world.threads(), simdLevelName(detectSimdLevel()));
+	std::printf("model\tstep\tms\tsteps/s\tspeed\tenergy\ttree error (%%)\tlist builds\n");
+
+	auto failed = 0;
+	for (const auto& path : models)
+	{
+		if (!run(path, world, options, exporter.get())) failed++;
+	}
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+#include "splatRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+splatRenderer::splatRenderer(const int threads) : pool(threads)
+{
+}
+
+bool splatRenderer::bounds(const particleBuffer& particles, const int i, int& x0, int& y0, int& x1, int& y1) const
+{
+	// pixels whose center is within the radius and the soft edge, none for the particles off the image of an
+	// unbounded run
+	const float px = particles.x[i] * scaleX;
+	const float py = particles.y[i] * scaleY;
+	const float reach = pixelRadius + 0.5F;
+	if (!(px + reach > 0.0F && py + reach > 0.0F && px - reach < imageWidth && py - reach < imageHeight)) return false;
+	x0 = std::max(static_cast<int>(std::ceil(px - reach - 0.5F)), 0);
+	y0 = std::max(static_cast<int>(std::ceil(py - reach - 0.5F)), 0);
+	x1 = std::min(static_cast<int>(std::floor(px + reach - 0.5F)), imageWidth - 1);
+	y1 = std::min(static_cast<int>(std::floor(py + reach - 0.5F)), imageHeight - 1);
+	return x0 <= x1 && y0 <= y1;
+}
+
+void splatRenderer::count(const particleBuffer& particles, const int c)
+{
+	uint32_t* tiles = &counts[static_cast<size_t>(c) * columns * rows];
+	for (auto i = chunks[c].first; i < chunks[c].last; i++)
+	{
+		int x0, y0, x1, y1;
+		if (!bounds(particles, i, x0, y0, x1, y1)) continue;
+		for (auto ty = y0 / SPLAT_TILE; ty <= y1 / SPLAT_TILE; ty++)
+		{
+			for (auto tx = x0 / SPLAT_TILE; tx <= x1 / SPLAT_TILE; tx++) tiles[ty * columns + tx]++;
+		}
+	}
+}
+
+void splatRenderer::prefix()
+{
+	// the chunks follow each other in every tile, so each list keeps the drawing order
+	const size_t tiles = static_cast<size_t>(columns) * rows;
+	uint32_t offset = 0;
+	for (size_t t = 0; t < tiles; t++)
+	{
+		tileStart[t] = offset;
+		for (size_t c = 0; c < chunks.size(); c++)
+		{
+			const uint32_t n = counts[c * tiles + t];
+			counts[c * tiles + t] = offset;
+			offset += n;
+		}
+	}
+	tileStart[tiles] = offset;
+	lists.resize(offset);
+}
+
+void splatRenderer::scatter(const particleBuffer& particles, const int c)
+{
+	uint32_t* next = &counts[static_cast<size_t>(c) * columns * rows];
+	for (auto i = chunks[c].first; i < chunks[c].last; i++)
+	{
+		int x0, y0, x1, y1;
+		if (!bounds(particles, i, x0, y0, x1, y1)) continue;
+		for (auto ty = y0 / SPLAT_TILE; ty <= y1 / SPLAT_TILE; ty++)
+		{
+			for (auto tx = x0 / SPLAT_TILE; tx <= x1 / SPLAT_TILE; tx++) lists[next[ty * columns + tx]++] = i;
+		}
+	}
+}
+
+void splatRenderer::rasterize(const particleBuffer& particles, const int tileX, const int tileY)
+{
+	const int left = tileX * SPLAT_TILE;
+	const int top = tileY * SPLAT_TILE;
+	const int right = std::min(left + SPLAT_TILE, imageWidth) - 1;
+	const int bottom = std::min(top + SPLAT_TILE, imageHeight) - 1;
+	for (auto y = top; y <= bottom; y++)
+	{
+		uint8_t* pixel = &band[(static_cast<size_t>(y - top) * imageWidth + left) * 4];
+		for (auto x = left; x <= right; x++, pixel += 4)
+		{
+			pixel[0] = pixel[1] = pixel[2] = 0;
+			pixel[3] = 255;
+		}
+	}
+
+	const size_t tile = static_cast<size_t>(tileY) * columns + tileX;
+	for (auto k = tileStart[tile]; k < tileStart[tile + 1]; k++)
+	{
+		const int i = lists[k];
+		int x0, y0, x1, y1;
+		bounds(particles, i, x0, y0, x1, y1);
+		const float px = particles.x[i] * scaleX;
+		const float py = particles.y[i] * scaleY;
+		const auto type = std::upper_bound(particles.start.begin(), particles.start.end(), i) - particles.start.begin() - 1;
+		const particleColor& color = particles.color[type];
+		for (auto y = std::max(y0, top); y <= std::min(y1, bottom); y++)
+		{
+			const float dy = y + 0.5F - py;
+			uint8_t* pixel = &band[(static_cast<size_t>(y - top) * imageWidth + std::max(x0, left)) * 4];
+			for (auto x = std::max(x0, left); x <= std::min(x1, right); x++, pixel += 4)
+			{
+				// coverage of the soft edge, then the blend of the window
+				const float dx = x + 0.5F - px;
+				const float coverage = pixelRadius + 0.5F - std::sqrt(dx * dx + dy * dy);
+				if (coverage <= 0.0F) continue;
+				const int a = static_cast<int>(alpha * std::min(coverage, 1.0F) + 0.5F);
+				pixel[0] = static_cast<uint8_t>((color.r * a + pixel[0] * (255 - a) + 127) / 255);
+				pixel[1] = static_cast<uint8_t>((color.g * a + pixel[1] * (255 - a) + 127) / 255);
+				pixel[2] = static_cast<uint8_t>((color.b * a + pixel[2] * (255 - a) + 127) / 255);
+			}
+		}
+	}
+}
+
+bool splatRenderer::render(const particleBuffer& particles, const std::vector<bool>& active, const float canvasWidth, const float canvasHeight,
+	const int width, const int height, const bandSink& sink)
+{
+	if (width <= 0 || height <= 0 || canvasWidth <= 0.0F || canvasHeight <= 0.0F) return true;
+	imageWidth = width;
+	imageHeight = height;
+	columns = (width + SPLAT_TILE - 1) / SPLAT_TILE;
+	rows = (height + SPLAT_TILE - 1) / SPLAT_TILE;
+	scaleX = width / canvasWidth;
+	scaleY = height / canvasHeight;
+	pixelRadius = radius * std::min(scaleX, scaleY);
+
+	// drawing order of the window, the third and the fourth groups swapped
+	chunks.clear();
+	for (auto k = 0; k < particles.types(); k++)
+	{
+		const int t = particles.types() > 3 && (k == 2 || k == 3) ? 5 - k : k;
+		if (t >= static_cast<int>(active.size()) || !active[t]) continue;
+		for (auto first = particles.start[t]; first < particles.start[t + 1]; first += SPLAT_CHUNK)
+		{
+			chunks.push_back({ first, std::min(first + SPLAT_CHUNK, particles.start[t + 1]) });
+		}
+	}
+
+	const size_t tiles = static_cast<size_t>(columns) * rows;
+	counts.assign(chunks.size() * tiles, 0);
+	tileStart.resize(tiles + 1);
+	const int work = static_cast<int>(chunks.size());
+	stages.clear();
+	stages.push_back({ work, [this, &particles](const int c) { count(particles, c); } });
+	stages.push_back({ 1, [this](int) { prefix(); } });
+	stages.push_back({ work, [this, &particles](const int c) { scatter(particles, c); } });
+	pool.run(stages);
+
+	band.resize(static_cast<size_t>(width) * SPLAT_TILE * 4);
+	for (auto tileY = 0; tileY < rows; tileY++)
+	{
+		stages.clear();
+		stages.push_back({ columns, [this, &particles, tileY](const int tileX) { rasterize(particles, tileX, tileY); } });
+		pool.run(stages);
+		const int first = tileY * SPLAT_TILE;
+		if (!sink(band.data(), first, std::min(SPLAT_TILE, height - first))) return false;
+	}
+	return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "simulation.h"
+#include "threadPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*
+ * Software rasterizer of the particles, for the pictures of the headless runner on machines without a GPU.
+ * Every particle is splatted as a disc with the color of its group and the opacity of the window, with the
+ * one pixel soft edge of the point renderer, over an opaque black background, in the drawing order of the
+ * window. The image is split into square tiles: the particles are first sorted into the tiles their disc
+ * touches, keeping their drawing order, then the tiles of a band of rows are rasterized in parallel and the
+ * band is handed to the caller before the next one is drawn, so only one band of pixels is ever held and
+ * frames far above 8K fit in memory.
+ */
+
+#define SPLAT_TILE 256 // pixels per side of a tile, rows of a band
+#define SPLAT_CHUNK 16384 // particles sorted by one tile of work
+
+class splatRenderer
+{
+public:
+	/**
+	 * @brief Rows of a band, RGBA from the top, width * 4 bytes per row
+	 *
+	 * @return false to stop the frame, when they cannot be written
+	 */
+	using bandSink = std::function<bool(const uint8_t* rows, int first, int count)>;
+
+	/**
+	 * @param threads number of threads including the caller of render(), 0 for one per core
+	 */
+	explicit splatRenderer(int threads = 0);
+
+	/**
+	 * @brief Draw the active groups, band by band
+	 *
+	 * @param particles positions, ranges and colors of the groups
+	 * @param active groups to draw
+	 * @param canvasWidth width of the canvas of the positions, mapped onto the width of the image
+	 * @param canvasHeight height of the canvas
+	 * @param width width of the image in pixels
+	 * @param height height of the image
+	 * @param sink receives the bands in order
+	 * @return false when the sink stopped the frame
+	 */
+	bool render(const particleBuffer& particles, const std::vector<bool>& active, float canvasWidth, float canvasHeight, int width, int height,
+		const bandSink& sink);
+
+	float radius = 2.25F;	// radius of the discs on the canvas, scaled with the image
+	int alpha = 100;		// opacity of the discs, 0 to 255
+
+private:
+	// particles of the drawing order sorted by one tile of work
+	struct chunk
+	{
+		int first;
+		int last;
+	};
+
+	// pixels of the image covered by the disc of a particle, last ones included, false when there are none
+	bool bounds(const particleBuffer& particles, int i, int& x0, int& y0, int& x1, int& y1) const;
+
+	// count the particles of a chunk in each tile
+	void count(const particleBuffer& particles, int c);
+
+	// offsets of every chunk in every tile
+	void prefix();
+
+	// write the particles of a chunk into the lists of their tiles
+	void scatter(const particleBuffer& particles, int c);
+
+	// clear one tile and draw its discs into the band
+	void rasterize(const particleBuffer& particles, int tileX, int tileY);
+
+	threadPool pool;
+	std::vector<threadPool::stage> stages;
+	std::vector<chunk> chunks;
+	int imageWidth = 0;
+	int imageHeight = 0;
+	int columns = 0;				// tiles per row
+	int rows = 0;					// tiles per column
+	float scaleX = 1.0F;
+	float scaleY = 1.0F;
+	float pixelRadius = 0.0F;
+	std::vector<uint32_t> counts;	// particles of each chunk in each tile, chunk major, then their offsets
+	std::vector<uint32_t> tileStart;	// first particle of each tile in the lists, and the end
+	std::vector<int> lists;			// particles of every tile, in drawing order
+	std::vector<uint8_t> band;		// RGBA pixels of SPLAT_TILE rows
+};
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <vector>
 #include <random>
+#include <cmath>
 
 // parameters for GUI
 constexpr float xshift = 400;
@@ -108,83 +109,128 @@ std::vector<point> CreatePoints(const int num, const int r, const int g, const i
 }
 
 /**
- * @brief Interaction between 2 particle groups
+ * @brief Sort the positions of a group by cell
+ *
+ * @param points the interacting group
+ * @param radius largest radius of the interaction, the smallest cell size
+ * @param width canvas width
+ * @param height canvas height
+ */
+void grid::build(const std::vector<point>& points, const float radius, const int width, const int height)
+{
+	cellSize = std::max({ radius, static_cast<float>(width) / GRID_MAX_CELLS, static_cast<float>(height) / GRID_MAX_CELLS, 1.0F });
+	cols = std::max(static_cast<int>(std::ceil(width / cellSize)), 1);
+	rows = std::max(static_cast<int>(std::ceil(height / cellSize)), 1);
+
+	// counting sort: count the points of each cell, turn the counts into first indices, then scatter
+	const auto n = points.size();
+	cellStart.assign(cols * rows + 1, 0);
+	cellOf.resize(n);
+	px.resize(n);
+	py.resize(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		cellOf[i] = cellY(points[i].y) * cols + cellX(points[i].x);
+		cellStart[cellOf[i] + 1]++;
+	}
+	for (auto c = 0; c < cols * rows; c++) cellStart[c + 1] += cellStart[c];
+	std::vector<int> next(cellStart.begin(), cellStart.end() - 1);
+	for (size_t i = 0; i < n; i++)
+	{
+		const int slot = next[cellOf[i]]++;
+		px[slot] = points[i].x;
+		py[slot] = points[i].y;
+	}
+}
+
+/**
+ * @brief Interaction between 2 particle groups, with an attraction and a repulsion of their own radius
+ *
+ * Both forces act inside the smaller radius, only the force of the larger radius acts in the shell up to
+ * the larger radius. The neighbours come from the subdivision grid of Group2, the forces of the 2 shells
+ * are accumulated in one pass and the velocity is written once per particle.
  * @param Group1 the group that will be modified by the interaction
  * @param Group2 the interacting group (its value won't be modified)
- * @param G gravity coefficient
- * @param radius radius of interaction
+ * @param G attraction coefficient
+ * @param Gradius radius of the attraction
+ * @param Gprobability probability of the attraction, in percent
+ * @param A repulsion coefficient
+ * @param Aradius radius of the repulsion
+ * @param Aprobability probability of the repulsion, in percent
+ * @param viscosity viscosity of Group1
  */
 void ofApp::interaction(std::vector<point>* Group1, const std::vector<point>* Group2, const float G, const float Gradius, const float Gprobability, const float A, const float Aradius, const float Aprobability, const float viscosity)
 {
 	const float g = G;	//Gravity coefficient
 	const float a = A;	//Anti-Gravity coefficient
-	const auto group1size = Group1->size();
-	const auto group2size = Group2->size();
+	const float outer = Gradius > Aradius ? g : a;	//coefficient of the shell between the 2 radii
+	const float inner2 = std::min(Gradius, Aradius) * std::min(Gradius, Aradius);
+	const float outer2 = std::max(Gradius, Aradius) * std::max(Gradius, Aradius);
+	const auto group1size = static_cast<int>(Group1->size());
 	const bool radius_toggle = radiusToogle;
 	boundHeight = ofGetHeight();
 	boundWidth = ofGetWidth();
 
+	subdiv.build(*Group2, std::max(Gradius, Aradius), boundWidth, boundHeight);
+	const int group2size = static_cast<int>(subdiv.px.size());
+
 #pragma omp parallel
 	{
-		std::random_device rd;
+		std::minstd_rand rng(std::random_device{}());
 #pragma omp for
 		for (auto i = 0; i < group1size; i++)
 		{
-			if (rd() % 100 < Gprobability && rd() % 100 < Aprobability) {
+			if (rng() % 100 < Gprobability && rng() % 100 < Aprobability) {
 				auto& p1 = (*Group1)[i];
-				float fx = 0;
-				float fy = 0;
-				
+				float ix = 0;	//force inside the smaller radius
+				float iy = 0;
+				float ox = 0;	//force in the shell up to the larger radius
+				float oy = 0;
+
 				//This inner loop is, of course, where most of the CPU time is spent. Everything else is cheap
-				for (auto j = 0; j < group2size; j++)
+				const auto accumulate = [&](const int first, const int last)
 				{
-					const auto& p2 = (*Group2)[j];
-			
-					// you don't need sqrt to compare distance. (you need it to compute the actual distance however)
-					const auto dx = p1.x - p2.x;
-					const auto dy = p1.y - p2.y;
-					const auto r = dx * dx + dy * dy;
-
-					//Calculate the force in given bounds. 
-					using namespace std;
-					
-					// cout << std::min(Gradius, Aradius) << "\n";
-					if ((r <= min(Gradius, Aradius) || radius_toggle) && r != 0.0F)
+					for (auto k = first; k < last; k++)
 					{
-						fx += (dx / r);
-						fy += (dy / r);
-						//Calculate new velocity
-						p1.vx = ((p1.vx + (fx * (g + a))) * (1 - viscosity));
-						p1.vy = ((p1.vx + (fx * (g + a))) * (1 - viscosity) + worldGravity);
-						
-					}
-					
-					if ((min(Gradius, Aradius) < r <= max(Gradius, Aradius) || radius_toggle) && r != 0.0F)
-					{
-						fx += (dx / r);
-						fy += (dy / r);
-						if (Gradius <= Aradius)
+						// you don't need sqrt to compare distance. (you need it to compute the actual distance however)
+						const auto dx = p1.x - subdiv.px[k];
+						const auto dy = p1.y - subdiv.py[k];
+						const auto r = dx * dx + dy * dy;
+						if (r == 0.0F) continue;
+
+						if (r <= inner2 || radius_toggle)
 						{
-							//Calculate new velocity
-							p1.vx = ((p1.vx + (fx * a)) * (1 - viscosity));
-							p1.vy = ((p1.vx + (fx * a)) * (1 - viscosity) + worldGravity);
-							//Update position based on velocity
-							p1.x += p1.vx;
-							p1.y += p1.vy;
+							ix += dx / r;
+							iy += dy / r;
 						}
-						if (Gradius > Aradius)
+						else if (r <= outer2)
 						{
-							//Calculate new velocity
-							p1.vx = ((p1.vx + (fx * g)) * (1 - viscosity));
-							p1.vy = ((p1.vx + (fx * g)) * (1 - viscosity) + worldGravity);
-							
+							ox += dx / r;
+							oy += dy / r;
 						}
-					}				
+					}
+				};
+
+				if (radius_toggle)
+				{
+					accumulate(0, group2size);
 				}
-				
-				
-					
-				
+				else
+				{
+					const int cx = subdiv.cellX(p1.x);
+					const int cy = subdiv.cellY(p1.y);
+					for (auto y = std::max(cy - 1, 0); y <= std::min(cy + 1, subdiv.rows - 1); y++)
+					{
+						// the cells of a row are contiguous
+						const int row = y * subdiv.cols;
+						accumulate(subdiv.cellStart[row + std::max(cx - 1, 0)], subdiv.cellStart[row + std::min(cx + 1, subdiv.cols - 1) + 1]);
+					}
+				}
+
+				//Calculate new velocity
+				p1.vx = (p1.vx + ix * (g + a) + ox * outer) * (1 - viscosity);
+				p1.vy = (p1.vy + iy * (g + a) + oy * outer) * (1 - viscosity) + worldGravity;
+
 				// Wall Repel
 				if (wallRepel > 0.0F)
 				{
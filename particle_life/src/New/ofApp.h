@@ -3,7 +3,7 @@
 #include "ofMain.h"
 #include "ofxGui.h"
 
-#define GRID_DIV 4
+#define GRID_MAX_CELLS 256 // cells per side of the subdivision grid
 
 /*
  * for collision detection :
@@ -36,9 +36,27 @@ struct point
 	}
 };
 
+/*
+ * Subdivision grid of the interacting group: its positions, sorted by cell. The cells are at least as
+ * wide as the largest radius of the interaction, so the neighbours of a particle are in the 3x3 cells
+ * around its own. The positions are copied when the grid is built, the interacting group can then be
+ * updated while the grid is read.
+ */
 struct grid
 {
-	const int gridSize = GRID_DIV * GRID_DIV; // must be a power of 2
+	float cellSize = 1.0F;
+	int cols = 1;
+	int rows = 1;
+	std::vector<int> cellStart;	// index of the first position of each cell, cols * rows + 1 entries
+	std::vector<int> cellOf;	// cell of each point of the group
+	std::vector<float> px;		// positions sorted by cell
+	std::vector<float> py;
+
+	void build(const std::vector<point>& points, float radius, int width, int height);
+
+	// positions outside of the canvas are clamped to the border cells
+	int cellX(const float x) const { return std::min(std::max(static_cast<int>(x / cellSize), 0), cols - 1); }
+	int cellY(const float y) const { return std::min(std::max(static_cast<int>(y / cellSize), 0), rows - 1); }
 };
 
 //---------------------------------------------CONFIGURE GUI---------------------------------------------//
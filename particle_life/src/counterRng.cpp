@@ -0,0 +1,138 @@
+#include "counterRng.h"
+#include "simd.h"
+
+#ifdef KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// Philox4x32 multipliers and Weyl key increments
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+// 24 random bits scaled to [0, 100)
+#define PERCENT_SCALE (100.0F / 16777216.0F)
+
+void philox4x32(const uint32_t counter[4], uint32_t key0, uint32_t key1, uint32_t out[4])
+{
+	uint32_t c0 = counter[0];
+	uint32_t c1 = counter[1];
+	uint32_t c2 = counter[2];
+	uint32_t c3 = counter[3];
+	for (auto round = 0; round < PHILOX_ROUNDS; round++)
+	{
+		const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0;
+		const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2;
+		c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ key0;
+		c1 = static_cast<uint32_t>(p1);
+		c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ key1;
+		c3 = static_cast<uint32_t>(p0);
+		key0 += PHILOX_W0;
+		key1 += PHILOX_W1;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+static void masksScalar(const uint64_t seed, const uint32_t frame, const int type, const int types, const float* probability,
+	const int first, const int count, uint32_t* masks)
+{
+	for (auto i = 0; i < count; i++)
+	{
+		uint32_t mask = 0;
+		for (auto block = 0; block * 4 < types; block++)
+		{
+			const uint32_t counter[4] = { static_cast<uint32_t>(first + i), frame, static_cast<uint32_t>(type), static_cast<uint32_t>(block) };
+			uint32_t words[4];
+			philox4x32(counter, static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), words);
+			for (auto w = 0; w < 4 && block * 4 + w < types; w++)
+			{
+				const int b = block * 4 + w;
+				if (static_cast<float>(words[w] >> 8) * PERCENT_SCALE < probability[b]) mask |= 1u << b;
+			}
+		}
+		masks[i] = mask;
+	}
+}
+
+#ifdef KERNEL_X86
+
+// high and low halves of the 32x32 bit products of each lane
+KERNEL_TARGET("avx2")
+static inline void mulhilo(const __m256i a, const __m256i m, __m256i& hi, __m256i& lo)
+{
+	const __m256i even = _mm256_mul_epu32(a, m);
+	const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+	hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+	lo = _mm256_mullo_epi32(a, m);
+}
+
+// eight particles per iteration, one per lane
+KERNEL_TARGET("avx2")
+static void masksAvx2(const uint64_t seed, const uint32_t frame, const int type, const int types, const float* probability,
+	const int first, const int count, uint32_t* masks)
+{
+	const __m256i m0 = _mm256_set1_epi32(static_cast<int>(PHILOX_M0));
+	const __m256i m1 = _mm256_set1_epi32(static_cast<int>(PHILOX_M1));
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256 scale = _mm256_set1_ps(PERCENT_SCALE);
+
+	auto i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		uint32_t laneMasks[8] = { 0 };
+		for (auto block = 0; block * 4 < types; block++)
+		{
+			__m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(first + i), lane);
+			__m256i c1 = _mm256_set1_epi32(static_cast<int>(frame));
+			__m256i c2 = _mm256_set1_epi32(type);
+			__m256i c3 = _mm256_set1_epi32(block);
+			uint32_t key0 = static_cast<uint32_t>(seed);
+			uint32_t key1 = static_cast<uint32_t>(seed >> 32);
+			for (auto round = 0; round < PHILOX_ROUNDS; round++)
+			{
+				__m256i hi0, lo0, hi1, lo1;
+				mulhilo(c0, m0, hi0, lo0);
+				mulhilo(c2, m1, hi1, lo1);
+				c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(key0)));
+				c1 = lo1;
+				c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(key1)));
+				c3 = lo0;
+				key0 += PHILOX_W0;
+				key1 += PHILOX_W1;
+			}
+
+			const __m256i words[4] = { c0, c1, c2, c3 };
+			for (auto w = 0; w < 4 && block * 4 + w < types; w++)
+			{
+				const int b = block * 4 + w;
+				const __m256 percent = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(words[w], 8)), scale);
+				const int bits = _mm256_movemask_ps(_mm256_cmp_ps(percent, _mm256_set1_ps(probability[b]), _CMP_LT_OQ));
+				for (auto l = 0; l < 8; l++) laneMasks[l] |= static_cast<uint32_t>((bits >> l) & 1) << b;
+			}
+		}
+		for (auto l = 0; l < 8; l++) masks[i + l] = laneMasks[l];
+	}
+
+	masksScalar(seed, frame, type, types, probability, first + i, count - i, masks + i);
+}
+
+#endif
+
+void fillProbabilityMasks(const uint64_t seed, const uint32_t frame, const int type, const int types, const float* probability,
+	const int first, const int count, uint32_t* masks)
+{
+#ifdef KERNEL_X86
+	static const bool avx2 = detectSimdLevel() >= simdLevel::avx2;
+	if (avx2)
+	{
+		masksAvx2(seed, frame, type, types, probability, first, count, masks);
+		return;
+	}
+#endif
+	masksScalar(seed, frame, type, types, probability, first, count, masks);
+}
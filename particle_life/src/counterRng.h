@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Counter based random numbers (Philox4x32-10, Salmon et al. 2011).
+ * A draw is a pure function of a counter and a key: there is no generator state to share between
+ * threads, and the same seed always gives the same draws in the same places, whatever the thread count.
+ */
+
+/**
+ * @brief Four random words for a counter and a key
+ *
+ * @param counter 128 bit counter
+ * @param key0 low word of the key
+ * @param key1 high word of the key
+ * @param out four random words
+ */
+void philox4x32(const uint32_t counter[4], uint32_t key0, uint32_t key1, uint32_t out[4]);
+
+/**
+ * @brief Probability test of a range of particles of one group against every group
+ *
+ * Bit b of masks[i] is set when particle (first + i) of group `type` interacts with group b this frame,
+ * that is when its draw for the pair (type, b) is below probability[b] percent. The draw of a particle is
+ * keyed by the seed and counts on (particle index, frame, type), so each pair gets its own number.
+ *
+ * @param seed simulation seed
+ * @param frame frame number
+ * @param type group of the particles
+ * @param types number of acting groups (at most 32)
+ * @param probability interaction probability of each acting group, in percent
+ * @param first index of the first particle in its group
+ * @param count number of particles
+ * @param masks one mask per particle
+ */
+void fillProbabilityMasks(uint64_t seed, uint32_t frame, int type, int types, const float* probability, int first, int count, uint32_t* masks);
@@ -0,0 +1,96 @@
+#include "densityMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+densityMap::densityMap(const int threads) : pool(threads)
+{
+	for (auto& peak : peaks) peak = 0;
+}
+
+void densityMap::render(const particleBuffer& particles, const std::vector<bool>& active, const float canvasWidth, const float canvasHeight,
+	const int width, const int height)
+{
+	if (width <= 0 || height <= 0 || canvasWidth <= 0.0F || canvasHeight <= 0.0F) return;
+	const size_t size = static_cast<size_t>(width) * height;
+	if (width != imageWidth || height != imageHeight)
+	{
+		counts.reset(new std::atomic<uint32_t>[size]);
+		for (size_t i = 0; i < size; i++) counts[i] = 0;
+		light.assign(size * 3, 0.0F);
+		pixels.assign(size * 4, 255);
+		imageWidth = width;
+		imageHeight = height;
+	}
+
+	// each group is binned once its predecessor has been tone mapped, the histogram is shared
+	const float scaleX = width / canvasWidth;
+	const float scaleY = height / canvasHeight;
+	const int rowTiles = (height + DENSITY_TILE_ROWS - 1) / DENSITY_TILE_ROWS;
+	stages.clear();
+	for (auto t = 0; t < particles.types(); t++)
+	{
+		if (t >= static_cast<int>(active.size()) || !active[t] || particles.count(t) == 0) continue;
+		peaks[t] = 0;
+		const int particleTiles = (particles.count(t) + DENSITY_TILE_PARTICLES - 1) / DENSITY_TILE_PARTICLES;
+		stages.push_back({ particleTiles, [this, &particles, t, scaleX, scaleY](const int tile) { bin(particles, t, tile, scaleX, scaleY); } });
+		stages.push_back({ rowTiles, [this, &particles, t](const int tile) { tone(particles.color[t], t, tile); } });
+	}
+	stages.push_back({ rowTiles, [this](const int tile) { resolve(tile); } });
+	pool.run(stages);
+}
+
+void densityMap::bin(const particleBuffer& particles, const int type, const int tile, const float scaleX, const float scaleY)
+{
+	const int first = particles.start[type] + tile * DENSITY_TILE_PARTICLES;
+	const int last = std::min(first + DENSITY_TILE_PARTICLES, particles.start[type + 1]);
+	uint32_t peak = 0;
+	for (auto i = first; i < last; i++)
+	{
+		// particles off the canvas of an unbounded run are not shown
+		const float px = particles.x[i] * scaleX;
+		const float py = particles.y[i] * scaleY;
+		if (!(px >= 0.0F && px < imageWidth && py >= 0.0F && py < imageHeight)) continue;
+		const size_t pixel = static_cast<size_t>(py) * imageWidth + static_cast<size_t>(px);
+		peak = std::max(peak, counts[pixel].fetch_add(1, std::memory_order_relaxed) + 1);
+	}
+
+	uint32_t seen = peaks[type].load(std::memory_order_relaxed);
+	while (peak > seen && !peaks[type].compare_exchange_weak(seen, peak, std::memory_order_relaxed)) {}
+}
+
+void densityMap::tone(const particleColor& color, const int type, const int tile)
+{
+	const uint32_t peak = peaks[type].load(std::memory_order_relaxed);
+	if (peak == 0) return;
+	const float scale = exposure / std::log1p(static_cast<float>(peak));
+	const float r = color.r / 255.0F * scale;
+	const float g = color.g / 255.0F * scale;
+	const float b = color.b / 255.0F * scale;
+	const size_t first = static_cast<size_t>(tile) * DENSITY_TILE_ROWS * imageWidth;
+	const size_t last = std::min(static_cast<size_t>(tile + 1) * DENSITY_TILE_ROWS, static_cast<size_t>(imageHeight)) * imageWidth;
+	for (auto i = first; i < last; i++)
+	{
+		const uint32_t count = counts[i].load(std::memory_order_relaxed);
+		if (count == 0) continue;
+		counts[i].store(0, std::memory_order_relaxed);
+		const float level = std::log1p(static_cast<float>(count));
+		light[3 * i] += r * level;
+		light[3 * i + 1] += g * level;
+		light[3 * i + 2] += b * level;
+	}
+}
+
+void densityMap::resolve(const int tile)
+{
+	const size_t first = static_cast<size_t>(tile) * DENSITY_TILE_ROWS * imageWidth;
+	const size_t last = std::min(static_cast<size_t>(tile + 1) * DENSITY_TILE_ROWS, static_cast<size_t>(imageHeight)) * imageWidth;
+	for (auto i = first; i < last; i++)
+	{
+		for (auto c = 0; c < 3; c++)
+		{
+			pixels[4 * i + c] = static_cast<uint8_t>(std::min(light[3 * i + c], 1.0F) * 255.0F + 0.5F);
+			light[3 * i + c] = 0.0F;
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "simulation.h"
+#include "threadPool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * Density heatmap of the particles, for the runs where there are too many of them to draw one by one.
+ * Each group is binned into a histogram of the resolution of the image, one particle adding one to the
+ * pixel it falls in, then the histogram is tone mapped into the color of the group, on a logarithmic scale
+ * from an empty pixel to the densest one of the group, and the groups are added together. The bins go
+ * through atomic counters, so the tiles of particles run in parallel and the counts never depend on the
+ * threads. Binning is a single pass over the particles; everything else is a pass over the pixels per
+ * group, so the cost of a frame follows the resolution of the image rather than the number of particles.
+ * It runs on its own thread pool, apart from the one of the simulation.
+ */
+
+#define DENSITY_TILE_ROWS 16 // rows of pixels of a tile
+#define DENSITY_TILE_PARTICLES 16384 // particles of a tile
+
+class densityMap
+{
+public:
+	/**
+	 * @param threads number of threads including the caller of render(), 0 for one per core
+	 */
+	explicit densityMap(int threads = 0);
+
+	/**
+	 * @brief Bin the active groups and tone map them into the image
+	 *
+	 * @param particles positions, ranges and colors of the groups
+	 * @param active groups to show
+	 * @param canvasWidth width of the canvas of the positions, mapped onto the width of the image
+	 * @param canvasHeight height of the canvas
+	 * @param width width of the image in pixels
+	 * @param height height of the image
+	 */
+	void render(const particleBuffer& particles, const std::vector<bool>& active, float canvasWidth, float canvasHeight, int width, int height);
+
+	// RGBA pixels of the last render, rows from the top, alpha always 255
+	const std::vector<uint8_t>& image() const { return pixels; }
+	int width() const { return imageWidth; }
+	int height() const { return imageHeight; }
+
+	float exposure = 1.0F;	// brightness of the densest pixel of each group
+
+private:
+	// add the particles of one tile of a group to the histogram
+	void bin(const particleBuffer& particles, int type, int tile, float scaleX, float scaleY);
+
+	// add one tile of rows of a group to the light of the pixels, emptying the histogram
+	void tone(const particleColor& color, int type, int tile);
+
+	// turn one tile of rows of light into pixels, emptying the light
+	void resolve(int tile);
+
+	threadPool pool;
+	std::vector<threadPool::stage> stages;
+	int imageWidth = 0;
+	int imageHeight = 0;
+	std::unique_ptr<std::atomic<uint32_t>[]> counts;	// histogram of the group being binned, imageWidth * imageHeight
+	std::atomic<uint32_t> peaks[TYPE_MAX];				// densest pixel of each group
+	std::vector<float> light;							// rgb of every pixel, sum of the groups
+	std::vector<uint8_t> pixels;
+};
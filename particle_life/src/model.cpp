@@ -0,0 +1,193 @@
+#include "model.h"
+
+#include <algorithm>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Visit every number of a model in the order of the file
+ *
+ * The first version had 7 groups, listed beta, alpha, delta, gamma... for the powers, radii and counts,
+ * and in slider order for the viscosities and probabilities. The teta entries came later, at the end.
+ *
+ * @param model model to read or to write
+ * @param visit called with a reference to each number, float or int
+ */
+template <typename Model, typename Visit>
+static void visitModel(Model& model, Visit visit)
+{
+	static const int legacy[7] = { 1, 0, 3, 2, 4, 5, 6 };	// beta, alpha, delta, gamma, epsilon, zeta, eta
+	static const int appended[7] = { 0, 1, 3, 2, 4, 5, 6 };	// alpha, beta, delta, gamma, epsilon, zeta, eta
+	const int teta = 7;
+	auto& m = model.matrix;
+
+	for (const int a : legacy)
+	{
+		for (const int b : legacy) visit(m.power[a][b]);
+		for (const int b : legacy) visit(m.radius[a][b]);
+	}
+	for (const int a : legacy) visit(model.count[a]);
+	visit(model.viscosity);
+	for (auto a = 0; a < teta; a++)
+	{
+		for (auto b = 0; b < teta; b++) visit(m.viscosity[a][b]);
+	}
+	visit(model.interactionEvoChance);
+	visit(model.interactionEvoAmount);
+	visit(model.probability);
+	for (auto a = 0; a < teta; a++)
+	{
+		for (auto b = 0; b < teta; b++) visit(m.probability[a][b]);
+	}
+	visit(model.minPower);
+	visit(model.maxPower);
+	visit(model.minRange);
+	visit(model.maxRange);
+	visit(model.probabilityEvoChance);
+	visit(model.probabilityEvoAmount);
+	visit(model.viscosityEvoChance);
+	visit(model.viscosityEvoAmount);
+
+	// teta
+	for (auto a = 0; a < teta; a++) visit(m.viscosity[a][teta]);
+	for (auto b = 0; b <= teta; b++) visit(m.viscosity[teta][b]);
+	for (auto a = 0; a < teta; a++) visit(m.probability[a][teta]);
+	for (auto b = 0; b <= teta; b++) visit(m.probability[teta][b]);
+	visit(model.count[teta]);
+	for (const int a : appended) visit(m.power[a][teta]);
+	for (const int b : appended) visit(m.power[teta][b]);
+	visit(m.power[teta][teta]);
+	for (const int a : appended) visit(m.radius[a][teta]);
+	for (const int b : appended) visit(m.radius[teta][b]);
+	visit(m.radius[teta][teta]);
+
+	visit(model.minViscosity);
+	visit(model.maxViscosity);
+	visit(model.minProbability);
+	visit(model.maxProbability);
+}
+
+bool loadModel(const std::string& path, simulationModel& model)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) return false;
+
+	std::vector<float> p;
+	float value;
+	while (p.size() < MODEL_SIZE && file >> value) p.push_back(value);
+	if (p.size() < MODEL_SIZE) return false;
+
+	simulationModel loaded;
+	size_t k = 0;
+	visitModel(loaded, [&](auto& entry) { entry = static_cast<std::remove_reference_t<decltype(entry)>>(p[k++]); });
+	model = loaded;
+	return true;
+}
+
+bool saveModel(const std::string& path, const simulationModel& model)
+{
+	if (model.types() != TYPE_COUNT) return false;
+	std::ofstream file(path);
+	if (!file.is_open()) return false;
+
+	visitModel(model, [&](const auto& entry) { file << static_cast<float>(entry) << " "; });
+	return static_cast<bool>(file);
+}
+
+/**
+ * @brief Uniform random float in [a, b)
+ */
+static float randomFloat(std::mt19937& rng, const float a, const float b)
+{
+	return std::uniform_real_distribution<float>(a, b)(rng);
+}
+
+void randomizeCounts(simulationModel& model, std::mt19937& rng)
+{
+	for (auto& count : model.count) count = std::uniform_int_distribution<int>(500, 1999)(rng);
+}
+
+void randomizeViscosity(simulationModel& model, std::mt19937& rng)
+{
+	model.viscosity = randomFloat(rng, model.minViscosity, model.maxViscosity);
+	for (auto& viscosity : model.matrix.viscosity.values) viscosity = randomFloat(rng, model.minViscosity, model.maxViscosity);
+}
+
+void randomizeProbability(simulationModel& model, std::mt19937& rng)
+{
+	model.probability = randomFloat(rng, model.minProbability, model.maxProbability);
+	for (auto& probability : model.matrix.probability.values) probability = randomFloat(rng, model.minProbability, model.maxProbability);
+}
+
+void randomizeInteractions(simulationModel& model, std::mt19937& rng, const float forceVariance, const float radiusVariance)
+{
+	for (auto a = 0; a < model.types(); a++)
+	{
+		for (auto b = 0; b < model.types(); b++)
+		{
+			model.matrix.power[a][b] = randomFloat(rng, model.minPower, model.maxPower) * forceVariance;
+			model.matrix.radius[a][b] = randomFloat(rng, model.minRange, model.maxRange) * radiusVariance;
+		}
+	}
+}
+
+void randomizeRelations(simulationModel& model, std::mt19937& rng, const float forceVariance, const float radiusVariance)
+{
+	randomizeViscosity(model, rng);
+	randomizeProbability(model, rng);
+	randomizeInteractions(model, rng, forceVariance, radiusVariance);
+}
+
+void randomizeModel(simulationModel& model, std::mt19937& rng, const float forceVariance, const float radiusVariance)
+{
+	model.interactionEvoChance = randomFloat(rng, 0.1F, 1.5F);
+	model.interactionEvoAmount = randomFloat(rng, 0.1F, 3.0F);
+	model.probabilityEvoChance = randomFloat(rng, 0.1F, 1.5F);
+	model.probabilityEvoAmount = randomFloat(rng, 0.1F, 3.0F);
+	model.viscosityEvoChance = randomFloat(rng, 0.1F, 1.5F);
+	model.viscosityEvoAmount = randomFloat(rng, 0.1F, 3.0F);
+	randomizeCounts(model, rng);
+	randomizeRelations(model, rng, forceVariance, radiusVariance);
+}
+
+void freezeModel(simulationModel& model)
+{
+	model.interactionEvoChance = 0.3F;
+	model.interactionEvoAmount = 0.3F;
+	model.probabilityEvoChance = 0.2F;
+	model.probabilityEvoAmount = 0.2F;
+	model.viscosityEvoChance = 0.1F;
+	model.viscosityEvoAmount = 0.1F;
+	model.viscosity = 100.0F;
+	model.probability = 0.0F;
+	for (auto a = 0; a < model.types(); a++)
+	{
+		for (auto b = 0; b < model.types(); b++)
+		{
+			model.matrix.viscosity[a][b] = 100.0F;
+			model.matrix.probability[a][b] = 0.0F;
+			model.matrix.power[a][b] = 0.0F;
+			model.matrix.radius[a][b] = 0.0F;
+		}
+	}
+}
+
+void resizeModel(simulationModel& model, const int types, std::mt19937& rng, const float forceVariance, const float radiusVariance)
+{
+	const int kept = std::min(model.types(), types);
+	model.matrix.resize(types);
+	model.count.resize(types, 0);
+	for (auto a = 0; a < types; a++)
+	{
+		if (a >= kept) model.count[a] = std::uniform_int_distribution<int>(500, 1999)(rng);
+		for (auto b = 0; b < types; b++)
+		{
+			if (a < kept && b < kept) continue;
+			model.matrix.power[a][b] = randomFloat(rng, model.minPower, model.maxPower) * forceVariance;
+			model.matrix.radius[a][b] = randomFloat(rng, model.minRange, model.maxRange) * radiusVariance;
+			model.matrix.viscosity[a][b] = randomFloat(rng, model.minViscosity, model.maxViscosity);
+			model.matrix.probability[a][b] = randomFloat(rng, model.minProbability, model.maxProbability);
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "simulation.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#define MODEL_SIZE 280 // numbers in a model file
+
+/*
+ * A model, as saved by the "Save Model" button: the parameters of every pair of groups, the particle
+ * counts, and the settings of the randomizers and of the evolution.
+ * The file is a plain list of numbers separated by spaces, in the order of the first 7 group version
+ * with the teta entries appended at the end. It always holds TYPE_COUNT groups, a model with another
+ * number of groups only lives in memory.
+ */
+struct simulationModel
+{
+	interactionMatrix matrix;
+	std::vector<int> count = std::vector<int>(TYPE_COUNT, 0);
+
+	// single viscosity and probability sliders
+	float viscosity = 0.7F;
+	float probability = 100.0F;
+
+	// bounds of the randomizers
+	float minPower = -200.0F;
+	float maxPower = 200.0F;
+	float minRange = 0.0F;
+	float maxRange = 500.0F;
+	float minViscosity = 0.0F;
+	float maxViscosity = 1.0F;
+	float minProbability = 0.0F;
+	float maxProbability = 100.0F;
+
+	// chance and amount of the parameter evolution, in percent
+	float interactionEvoChance = 0.0F;
+	float interactionEvoAmount = 0.0F;
+	float probabilityEvoChance = 0.0F;
+	float probabilityEvoAmount = 0.0F;
+	float viscosityEvoChance = 0.0F;
+	float viscosityEvoAmount = 0.0F;
+
+	int types() const { return matrix.types(); }
+};
+
+/**
+ * @brief Read a model file
+ *
+ * @param path file to read
+ * @param model read model of TYPE_COUNT groups, only written on success
+ * @return false when the file cannot be opened or holds less than MODEL_SIZE numbers
+ */
+bool loadModel(const std::string& path, simulationModel& model);
+
+/**
+ * @brief Write a model file
+ *
+ * @param path file to write
+ * @param model model to save
+ * @return false when the file cannot be written or when the model does not have TYPE_COUNT groups
+ */
+bool saveModel(const std::string& path, const simulationModel& model);
+
+/*
+ * Randomizers of the interface buttons. The ranges are the bounds of the model, the power and the
+ * radius are scaled down by their variance.
+ */
+
+// new particle count of every group
+void randomizeCounts(simulationModel& model, std::mt19937& rng);
+
+// new viscosities
+void randomizeViscosity(simulationModel& model, std::mt19937& rng);
+
+// new probabilities
+void randomizeProbability(simulationModel& model, std::mt19937& rng);
+
+// new powers and radii
+void randomizeInteractions(simulationModel& model, std::mt19937& rng, float forceVariance, float radiusVariance);
+
+// new viscosities, probabilities, powers and radii
+void randomizeRelations(simulationModel& model, std::mt19937& rng, float forceVariance, float radiusVariance);
+
+// a whole new model: evolution settings, counts and relations
+void randomizeModel(simulationModel& model, std::mt19937& rng, float forceVariance, float radiusVariance);
+
+// no more interactions: full viscosity, zero probability, power and radius, slow evolution
+void freezeModel(simulationModel& model);
+
+// another number of groups: the kept groups do not change, the new ones get random counts and relations
+void resizeModel(simulationModel& model, int types, std::mt19937& rng, float forceVariance, float radiusVariance);
@@ -1,9 +1,11 @@
 ﻿#include "ofApp.h"
 #include "ofUtils.h"
+#include "simd.h"
 
 #include <iostream>
 #include <vector>
 #include <random>
+#include <chrono>
 
 //int countThresh = 0;
 std::string fps_text;
@@ -16,193 +18,118 @@ float maxP = 200;
 float minR = 0;
 float maxR = 500;
 clock_t now, lastTime, delta;
-clock_t physic_begin, physic_delta;
-
-//Particle groups by color
-std::vector<point> alpha;
-std::vector<point> betha;
-std::vector<point> elta;
-std::vector<point> gamma;
-std::vector<point> epsilon;
-std::vector<point> zeta;
-std::vector<point> eta;
-std::vector<point> teta;
-
-
-//Subdivison grid
-grid subdiv;
-
-/**
- * @brief Return a random float in range [a,b]
- *
- * @param a lower bound
- * @param b higher bound
- * @return random float
- */
-inline float RandomFloat(const float a, const float b)
-{
-	const float diff = b - a;
-	const float r = ofRandomuf() * diff;
-	return a + r;
-}
-/**
- * @brief Return a random int in range [c,d]
- *
- * @param c lower bound
- * @param d higher bound
- * @return random int e
- */
-inline int RandomInt(const int c, const int d)
-{
-	const int e = ofRandom(c, d);
-	return e;
-
-}
-
-/**
- * @brief Draw all point from a given group of vector<point>*
- *
- * @param points a group of point
- */
-void Draw(const std::vector<point>* points)
-{
-	for (auto& point : *points) point.draw();
-}
 
 /**
- * @brief Generate a number of single colored points randomly distributed on canvas
+ * @brief Draw all point from a given group
  *
- * @param num number of point to generate
- * @param r red
- * @param g green
- * @param b blue
- * @param o orange
- * @param k khaki
- * @param c crimson
- * @return a group of random point
+ * @param points the points of every group
+ * @param type the group to draw
  */
-std::vector<point> CreatePoints(const int num, const int r, const int g, const int b)
+void Draw(const particleBuffer& points, const int type)
 {
-	std::vector<point> points;
-	points.reserve(num);
-	for (auto i = 0; i < num; i++)
+	const particleColor& color = points.color[type];
+	ofSetColor(color.r, color.g, color.b, 100); //set particle color + some alpha
+	for (auto i = points.start[type]; i < points.start[type + 1]; i++)
 	{
-		int x = static_cast<int>(ofRandomWidth());
-		int y = static_cast<int>(ofRandomHeight());
-		points.emplace_back(x, y, r, g, b);
+		ofDrawCircle(points.x[i], points.y[i], 2.25F); //draw a point at x,y coordinates, the size of a 2.25 pixels
 	}
-	return points;
 }
 
 /**
- * @brief Interaction between 2 particle groups
- * @param Group1 the group that will be modified by the interaction
- * @param Group2 the interacting group (its value won't be modified)
- * @param G gravity coefficient
- * @param radius radius of interaction
+ * @brief Body of the simulation thread
+ *
+ * Steps the simulation with the latest parameters from update() at a fixed rate, and after each step
+ * copies the positions into the back buffer of the snapshots for draw(), straight into its region of the
+ * stream of the renderer when there is one with enough room and the heatmap does not read them. The step
+ * count of a frame never depends on how fast the window draws: a slow frame shows the newest snapshot and
+ * skips the others, a fast one draws the same snapshot again. When the steps fall behind the target rate they are not
+ * caught up in a burst, the clock is reset instead.
  */
-void ofApp::interaction(std::vector<point>* Group1, const std::vector<point>* Group2, const float G, const float radius, const float viscosity, const float probability)
+void ofApp::simulate()
 {
-	const float g = G / -100;	//Gravity coefficient
-	const auto group1size = Group1->size();
-	const auto group2size = Group2->size();
-	const bool radius_toggle = radiusToogle;
-
-	boundHeight = ofGetHeight();
-	boundWidth = ofGetWidth();
-
-#pragma omp parallel
+	simulationParams current;
+	auto heatmapShown = false;
+	auto next = std::chrono::steady_clock::now();
+	while (simulating)
 	{
-		std::random_device rd;
-#pragma omp for
-		for (auto i = 0; i < group1size; i++)
+		float rate;
 		{
-			if (rd() % 100 < probability) {
-				auto& p1 = (*Group1)[i];
-				float fx = 0;
-				float fy = 0;
-
-				//This inner loop is, of course, where most of the CPU time is spent. Everything else is cheap
-				for (auto j = 0; j < group2size; j++)
-				{
-					const auto& p2 = (*Group2)[j];
-
-					// you don't need sqrt to compare distance. (you need it to compute the actual distance however)
-					const auto dx = p1.x - p2.x;
-					const auto dy = p1.y - p2.y;
-					const auto r = dx * dx + dy * dy;
-
-					//Calculate the force in given bounds. 
-					if ((r < radius * radius || radius_toggle) && r != 0.0F)
-					{
-						fx += (dx / std::sqrt(dx * dx + dy * dy));
-						fy += (dy / std::sqrt(dx * dx + dy * dy));
-					}
-				}
-				
-					
-				//Calculate new velocity
-				p1.vx = (p1.vx + (fx * g)) * (1 - viscosity);
-				p1.vy = (p1.vy + (fy * g)) * (1 - viscosity) + worldGravity;
-
-								
-				// Wall Repel
-				if (wallRepel > 0.0F)
-				{
-					if (p1.x < wallRepel) p1.vx += (wallRepel - p1.x) * 0.1;
-					if (p1.y < wallRepel) p1.vy += (wallRepel - p1.y) * 0.1;
-					if (p1.x > boundWidth - wallRepel) p1.vx += (boundWidth - wallRepel - p1.x) * 0.1;
-					if (p1.y > boundHeight - wallRepel) p1.vy += (boundHeight - wallRepel - p1.y) * 0.1;
-				}
-
-				
-
-				//Checking for canvas bounds
-				if (boundsToggle)
-				{
-					{
-						if (p1.x < 0)
-						{
-							p1.x += boundWidth;
-						}
-						else if (p1.x > boundWidth)
-						{
-							p1.x -= boundWidth;
-						}
+			std::lock_guard<std::mutex> lock(paramsMutex);
+			if (!paramsReady)
+			{
+				rate = -1.0F;
+			}
+			else
+			{
+				current = pendingParams;
+				rate = pendingRate;
+				heatmapShown = pendingHeatmap;
+			}
+		}
+		// nothing to step before the first update()
+		if (rate < 0.0F)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			next = std::chrono::steady_clock::now();
+			continue;
+		}
 
-						if (p1.y < 0)
-						{
-							p1.y += boundHeight;
-						}
-						else if (p1.y > boundHeight)
-						{
-							p1.y -= boundHeight;
-						}
-					}
-				}
-				//Update position based on velocity
-				p1.x += p1.vx;
-				p1.y += p1.vy;
+		{
+			std::lock_guard<std::mutex> lock(groupsMutex);
+			const auto begin = std::chrono::steady_clock::now();
+			world.step(current);
+			const auto end = std::chrono::steady_clock::now();
+
+			frameSnapshot& snapshot = snapshots.back();
+			snapshot.active = current.active;
+			snapshot.streamed = !heatmapShown && renderer.streaming() && world.particles.size() <= renderer.streamCapacity();
+			if (snapshot.streamed)
+			{
+				std::copy(world.particles.x.begin(), world.particles.x.end(), renderer.streamX(snapshot.region));
+				std::copy(world.particles.y.begin(), world.particles.y.end(), renderer.streamY(snapshot.region));
+				snapshot.generation = renderer.streamGeneration();
+			}
+			else
+			{
+				snapshot.particles.x = world.particles.x;
+				snapshot.particles.y = world.particles.y;
 			}
+			snapshot.particles.start = world.particles.start;
+			snapshot.particles.color = world.particles.color;
+			snapshot.frame = world.frame;
+			snapshot.stepMs = std::chrono::duration<float, std::milli>(end - begin).count();
+			snapshot.treeError = world.treeError;
+			snapshot.listBuilds = world.listBuilds();
+		}
+		snapshots.publish();
+
+		if (rate > 0.0F)
+		{
+			const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(1.0F / rate));
+			next += period;
+			const auto now = std::chrono::steady_clock::now();
+			if (next + period < now) next = now;
+			std::this_thread::sleep_until(next);
+		}
+		else
+		{
+			next = std::chrono::steady_clock::now();
 		}
 	}
 }
 
-/* omp end parallel */
-
 /**
  * @brief Generate new sets of points
  */
 void ofApp::restart()
 {
-	if (numberSliderα > 0) { alpha = CreatePoints(numberSliderα, ofRandom(0, 255), ofRandom(0, 255), ofRandom(0, 255)); }
-	if (numberSliderβ > 0) { betha = CreatePoints(numberSliderβ, ofRandom(0, 255), ofRandom(0, 255), ofRandom(0, 255)); }
-	if (numberSliderγ > 0) { gamma = CreatePoints(numberSliderγ, ofRandom(0, 255), ofRandom(0, 255), ofRandom(0, 255)); }
-	if (numberSliderδ > 0) { elta = CreatePoints(numberSliderδ, ofRandom(0, 255), ofRandom(0, 255), ofRandom(0, 255)); }
-	if (numberSliderε > 0) { epsilon = CreatePoints(numberSliderε, ofRandom(0, 255), ofRandom(0, 255), ofRandom(0, 255)); }
-	if (numberSliderζ > 0) { zeta = CreatePoints(numberSliderζ, ofRandom(0, 255), ofRandom(0, 255), ofRandom(0, 255)); }
-	if (numberSliderη > 0) { eta = CreatePoints(numberSliderη, ofRandom(0, 255), ofRandom(0, 255), ofRandom(0, 255)); }
-	if (numberSliderθ > 0) { teta = CreatePoints(numberSliderθ, ofRandom(0, 255), ofRandom(0, 255), ofRandom(0, 255)); }
+	int count[TYPE_COUNT];
+	for (auto t = 0; t < TYPE_COUNT; t++) count[t] = *numbersliders[t];
+
+	// the simulation thread must not step half replaced groups
+	std::lock_guard<std::mutex> lock(groupsMutex);
+	std::random_device rd;
+	world.restart(count, TYPE_COUNT, ofGetWidth(), ofGetHeight(), (static_cast<uint64_t>(rd()) << 32) | rd());
 }
 
 
@@ -211,1490 +138,52 @@ void ofApp::restart()
  */
 void ofApp::random()
 {
-	InteractionEvoProbSlider = RandomFloat(0.1, 1.5);
-	InteractionEvoAmountSlider = RandomFloat(0.1, 3);
-	ProbabilityEvoProbSlider = RandomFloat(0.1, 1.5);
-	ProbabilityEvoAmountSlider = RandomFloat(0.1, 3);
-	ViscosityEvoProbSlider = RandomFloat(0.1, 1.5);
-	ViscosityEvoAmountSlider = RandomFloat(0.1, 3);
-
-	numberSliderβ = RandomInt(500, 2000);
-	numberSliderα = RandomInt(500, 2000);
-	numberSliderδ = RandomInt(500, 2000);
-	numberSliderγ = RandomInt(500, 2000);
-	numberSliderε = RandomInt(500, 2000);
-	numberSliderζ = RandomInt(500, 2000);
-	numberSliderη = RandomInt(500, 2000);
-	numberSliderθ = RandomInt(500, 2000);
-
-	viscositySlider = RandomFloat(minV, maxV);
-
-	viscositySliderαα = RandomFloat(minV, maxV);
-	viscositySliderαβ = RandomFloat(minV, maxV);
-	viscositySliderαδ = RandomFloat(minV, maxV);
-	viscositySliderαγ = RandomFloat(minV, maxV);
-	viscositySliderαε = RandomFloat(minV, maxV);
-	viscositySliderαζ = RandomFloat(minV, maxV);
-	viscositySliderαη = RandomFloat(minV, maxV);
-
-	viscositySliderβα = RandomFloat(minV, maxV);
-	viscositySliderββ = RandomFloat(minV, maxV);
-	viscositySliderβδ = RandomFloat(minV, maxV);
-	viscositySliderβγ = RandomFloat(minV, maxV);
-	viscositySliderβε = RandomFloat(minV, maxV);
-	viscositySliderβζ = RandomFloat(minV, maxV);
-	viscositySliderβη = RandomFloat(minV, maxV);
-
-	viscositySliderγα = RandomFloat(minV, maxV);
-	viscositySliderγβ = RandomFloat(minV, maxV);
-	viscositySliderγδ = RandomFloat(minV, maxV);
-	viscositySliderγγ = RandomFloat(minV, maxV);
-	viscositySliderγε = RandomFloat(minV, maxV);
-	viscositySliderγζ = RandomFloat(minV, maxV);
-	viscositySliderγη = RandomFloat(minV, maxV);
-
-	viscositySliderδα = RandomFloat(minV, maxV);
-	viscositySliderδβ = RandomFloat(minV, maxV);
-	viscositySliderδδ = RandomFloat(minV, maxV);
-	viscositySliderδγ = RandomFloat(minV, maxV);
-	viscositySliderδε = RandomFloat(minV, maxV);
-	viscositySliderδζ = RandomFloat(minV, maxV);
-	viscositySliderδη = RandomFloat(minV, maxV);
-
-	viscositySliderεα = RandomFloat(minV, maxV);
-	viscositySliderεβ = RandomFloat(minV, maxV);
-	viscositySliderεδ = RandomFloat(minV, maxV);
-	viscositySliderεγ = RandomFloat(minV, maxV);
-	viscositySliderεε = RandomFloat(minV, maxV);
-	viscositySliderεζ = RandomFloat(minV, maxV);
-	viscositySliderεη = RandomFloat(minV, maxV);
-
-	viscositySliderζα = RandomFloat(minV, maxV);
-	viscositySliderζβ = RandomFloat(minV, maxV);
-	viscositySliderζδ = RandomFloat(minV, maxV);
-	viscositySliderζγ = RandomFloat(minV, maxV);
-	viscositySliderζε = RandomFloat(minV, maxV);
-	viscositySliderζζ = RandomFloat(minV, maxV);
-	viscositySliderζη = RandomFloat(minV, maxV);
-
-	viscositySliderηα = RandomFloat(minV, maxV);
-	viscositySliderηβ = RandomFloat(minV, maxV);
-	viscositySliderηδ = RandomFloat(minV, maxV);
-	viscositySliderηγ = RandomFloat(minV, maxV);
-	viscositySliderηε = RandomFloat(minV, maxV);
-	viscositySliderηζ = RandomFloat(minV, maxV);
-	viscositySliderηη = RandomFloat(minV, maxV);
-
-	viscositySliderαθ = RandomFloat(minV, maxV);
-	viscositySliderβθ = RandomFloat(minV, maxV);
-	viscositySliderδθ = RandomFloat(minV, maxV);
-	viscositySliderγθ = RandomFloat(minV, maxV);
-	viscositySliderεθ = RandomFloat(minV, maxV);
-	viscositySliderζθ = RandomFloat(minV, maxV);
-	viscositySliderηθ = RandomFloat(minV, maxV);
-	viscositySliderθα = RandomFloat(minV, maxV);
-	viscositySliderθβ = RandomFloat(minV, maxV);
-	viscositySliderθδ = RandomFloat(minV, maxV);
-	viscositySliderθγ = RandomFloat(minV, maxV);
-	viscositySliderθε = RandomFloat(minV, maxV);
-	viscositySliderθζ = RandomFloat(minV, maxV);
-	viscositySliderθη = RandomFloat(minV, maxV);
-	viscositySliderθθ = RandomFloat(minV, maxV);
-
-	probabilitySlider = RandomFloat(minI, maxI);
-
-	probabilitySliderαα = RandomFloat(minI, maxI);
-	probabilitySliderαβ = RandomFloat(minI, maxI);
-	probabilitySliderαγ = RandomFloat(minI, maxI);
-	probabilitySliderαδ = RandomFloat(minI, maxI);
-	probabilitySliderαε = RandomFloat(minI, maxI);
-	probabilitySliderαζ = RandomFloat(minI, maxI);
-	probabilitySliderαη = RandomFloat(minI, maxI);
-
-	probabilitySliderβα = RandomFloat(minI, maxI);
-	probabilitySliderββ = RandomFloat(minI, maxI);
-	probabilitySliderβγ = RandomFloat(minI, maxI);
-	probabilitySliderβδ = RandomFloat(minI, maxI);
-	probabilitySliderβε = RandomFloat(minI, maxI);
-	probabilitySliderβζ = RandomFloat(minI, maxI);
-	probabilitySliderβη = RandomFloat(minI, maxI);
-
-	probabilitySliderγα = RandomFloat(minI, maxI);
-	probabilitySliderγβ = RandomFloat(minI, maxI);
-	probabilitySliderγγ = RandomFloat(minI, maxI);
-	probabilitySliderγδ = RandomFloat(minI, maxI);
-	probabilitySliderγε = RandomFloat(minI, maxI);
-	probabilitySliderγζ = RandomFloat(minI, maxI);
-	probabilitySliderγη = RandomFloat(minI, maxI);
-
-	probabilitySliderδα = RandomFloat(minI, maxI);
-	probabilitySliderδβ = RandomFloat(minI, maxI);
-	probabilitySliderδγ = RandomFloat(minI, maxI);
-	probabilitySliderδδ = RandomFloat(minI, maxI);
-	probabilitySliderδε = RandomFloat(minI, maxI);
-	probabilitySliderδζ = RandomFloat(minI, maxI);
-	probabilitySliderδη = RandomFloat(minI, maxI);
-
-	probabilitySliderεα = RandomFloat(minI, maxI);
-	probabilitySliderεβ = RandomFloat(minI, maxI);
-	probabilitySliderεγ = RandomFloat(minI, maxI);
-	probabilitySliderεδ = RandomFloat(minI, maxI);
-	probabilitySliderεε = RandomFloat(minI, maxI);
-	probabilitySliderεζ = RandomFloat(minI, maxI);
-	probabilitySliderεη = RandomFloat(minI, maxI);
-
-	probabilitySliderζα = RandomFloat(minI, maxI);
-	probabilitySliderζβ = RandomFloat(minI, maxI);
-	probabilitySliderζγ = RandomFloat(minI, maxI);
-	probabilitySliderζδ = RandomFloat(minI, maxI);
-	probabilitySliderζε = RandomFloat(minI, maxI);
-	probabilitySliderζζ = RandomFloat(minI, maxI);
-	probabilitySliderζη = RandomFloat(minI, maxI);
-
-	probabilitySliderηα = RandomFloat(minI, maxI);
-	probabilitySliderηβ = RandomFloat(minI, maxI);
-	probabilitySliderηγ = RandomFloat(minI, maxI);
-	probabilitySliderηδ = RandomFloat(minI, maxI);
-	probabilitySliderηε = RandomFloat(minI, maxI);
-	probabilitySliderηζ = RandomFloat(minI, maxI);
-	probabilitySliderηη = RandomFloat(minI, maxI);
-
-	probabilitySliderαθ = RandomFloat(minI, maxI);
-	probabilitySliderβθ = RandomFloat(minI, maxI);
-	probabilitySliderγθ = RandomFloat(minI, maxI);
-	probabilitySliderδθ = RandomFloat(minI, maxI);
-	probabilitySliderεθ = RandomFloat(minI, maxI);
-	probabilitySliderζθ = RandomFloat(minI, maxI);
-	probabilitySliderηθ = RandomFloat(minI, maxI);
-	probabilitySliderθα = RandomFloat(minI, maxI);
-	probabilitySliderθβ = RandomFloat(minI, maxI);
-	probabilitySliderθγ = RandomFloat(minI, maxI);
-	probabilitySliderθδ = RandomFloat(minI, maxI);
-	probabilitySliderθε = RandomFloat(minI, maxI);
-	probabilitySliderθζ = RandomFloat(minI, maxI);
-	probabilitySliderθη = RandomFloat(minI, maxI);
-	probabilitySliderθθ = RandomFloat(minI, maxI);
-
-	// Alpha
-	//numberSliderα = RandomFloat(minR, 3000);
-	powerSliderαα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderαβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Betha
-	//numberSliderβ = RandomFloat(minR, 3000);
-	powerSliderββ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderββ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Gamma
-	//numberSliderγ = RandomFloat(minR, 3000);
-	powerSliderγγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderγβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Delta
-	// numberSliderδ = RandomFloat(minR, 3000);
-	powerSliderδδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderδβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Epsilon
-	//numberSliderε = RandomFloat(minR, 3000);
-	powerSliderεγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderεβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Zeta
-	//numberSliderζ = RandomFloat(minR, 3000);
-	powerSliderζγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderζβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Etha
-	//numberSliderη = RandomFloat(minR, 3000);
-	powerSliderηγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderηβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Tetha
-	//numberSliderθ = RandomFloat(minR, 3000);
-	powerSliderθγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderθβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθη = RandomFloat(minR, maxR) * radiusVariance;
-
-	powerSliderγθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθθ = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderβθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθθ = RandomFloat(minR, maxR) * radiusVariance;
+	simulationModel model = currentModel();
+	randomizeModel(model, rng, forceVariance, radiusVariance);
+	applyModel(model);
 }
 
 void ofApp::rndrel()
 {
-	viscositySlider = RandomFloat(minV, maxV);
-
-	viscositySliderαα = RandomFloat(minV, maxV);
-	viscositySliderαβ = RandomFloat(minV, maxV);
-	viscositySliderαδ = RandomFloat(minV, maxV);
-	viscositySliderαγ = RandomFloat(minV, maxV);
-	viscositySliderαε = RandomFloat(minV, maxV);
-	viscositySliderαζ = RandomFloat(minV, maxV);
-	viscositySliderαη = RandomFloat(minV, maxV);
-
-	viscositySliderβα = RandomFloat(minV, maxV);
-	viscositySliderββ = RandomFloat(minV, maxV);
-	viscositySliderβδ = RandomFloat(minV, maxV);
-	viscositySliderβγ = RandomFloat(minV, maxV);
-	viscositySliderβε = RandomFloat(minV, maxV);
-	viscositySliderβζ = RandomFloat(minV, maxV);
-	viscositySliderβη = RandomFloat(minV, maxV);
-
-	viscositySliderγα = RandomFloat(minV, maxV);
-	viscositySliderγβ = RandomFloat(minV, maxV);
-	viscositySliderγδ = RandomFloat(minV, maxV);
-	viscositySliderγγ = RandomFloat(minV, maxV);
-	viscositySliderγε = RandomFloat(minV, maxV);
-	viscositySliderγζ = RandomFloat(minV, maxV);
-	viscositySliderγη = RandomFloat(minV, maxV);
-
-	viscositySliderδα = RandomFloat(minV, maxV);
-	viscositySliderδβ = RandomFloat(minV, maxV);
-	viscositySliderδδ = RandomFloat(minV, maxV);
-	viscositySliderδγ = RandomFloat(minV, maxV);
-	viscositySliderδε = RandomFloat(minV, maxV);
-	viscositySliderδζ = RandomFloat(minV, maxV);
-	viscositySliderδη = RandomFloat(minV, maxV);
-
-	viscositySliderεα = RandomFloat(minV, maxV);
-	viscositySliderεβ = RandomFloat(minV, maxV);
-	viscositySliderεδ = RandomFloat(minV, maxV);
-	viscositySliderεγ = RandomFloat(minV, maxV);
-	viscositySliderεε = RandomFloat(minV, maxV);
-	viscositySliderεζ = RandomFloat(minV, maxV);
-	viscositySliderεη = RandomFloat(minV, maxV);
-
-	viscositySliderζα = RandomFloat(minV, maxV);
-	viscositySliderζβ = RandomFloat(minV, maxV);
-	viscositySliderζδ = RandomFloat(minV, maxV);
-	viscositySliderζγ = RandomFloat(minV, maxV);
-	viscositySliderζε = RandomFloat(minV, maxV);
-	viscositySliderζζ = RandomFloat(minV, maxV);
-	viscositySliderζη = RandomFloat(minV, maxV);
-
-	viscositySliderηα = RandomFloat(minV, maxV);
-	viscositySliderηβ = RandomFloat(minV, maxV);
-	viscositySliderηδ = RandomFloat(minV, maxV);
-	viscositySliderηγ = RandomFloat(minV, maxV);
-	viscositySliderηε = RandomFloat(minV, maxV);
-	viscositySliderηζ = RandomFloat(minV, maxV);
-	viscositySliderηη = RandomFloat(minV, maxV);
-
-	viscositySliderαθ = RandomFloat(minV, maxV);
-	viscositySliderβθ = RandomFloat(minV, maxV);
-	viscositySliderδθ = RandomFloat(minV, maxV);
-	viscositySliderγθ = RandomFloat(minV, maxV);
-	viscositySliderεθ = RandomFloat(minV, maxV);
-	viscositySliderζθ = RandomFloat(minV, maxV);
-	viscositySliderηθ = RandomFloat(minV, maxV);
-	viscositySliderθα = RandomFloat(minV, maxV);
-	viscositySliderθβ = RandomFloat(minV, maxV);
-	viscositySliderθδ = RandomFloat(minV, maxV);
-	viscositySliderθγ = RandomFloat(minV, maxV);
-	viscositySliderθε = RandomFloat(minV, maxV);
-	viscositySliderθζ = RandomFloat(minV, maxV);
-	viscositySliderθη = RandomFloat(minV, maxV);
-	viscositySliderθθ = RandomFloat(minV, maxV);
-
-	probabilitySlider = RandomFloat(minI, maxI);
-
-	probabilitySliderαα = RandomFloat(minI, maxI);
-	probabilitySliderαβ = RandomFloat(minI, maxI);
-	probabilitySliderαγ = RandomFloat(minI, maxI);
-	probabilitySliderαδ = RandomFloat(minI, maxI);
-	probabilitySliderαε = RandomFloat(minI, maxI);
-	probabilitySliderαζ = RandomFloat(minI, maxI);
-	probabilitySliderαη = RandomFloat(minI, maxI);
-
-	probabilitySliderβα = RandomFloat(minI, maxI);
-	probabilitySliderββ = RandomFloat(minI, maxI);
-	probabilitySliderβγ = RandomFloat(minI, maxI);
-	probabilitySliderβδ = RandomFloat(minI, maxI);
-	probabilitySliderβε = RandomFloat(minI, maxI);
-	probabilitySliderβζ = RandomFloat(minI, maxI);
-	probabilitySliderβη = RandomFloat(minI, maxI);
-
-	probabilitySliderγα = RandomFloat(minI, maxI);
-	probabilitySliderγβ = RandomFloat(minI, maxI);
-	probabilitySliderγγ = RandomFloat(minI, maxI);
-	probabilitySliderγδ = RandomFloat(minI, maxI);
-	probabilitySliderγε = RandomFloat(minI, maxI);
-	probabilitySliderγζ = RandomFloat(minI, maxI);
-	probabilitySliderγη = RandomFloat(minI, maxI);
-
-	probabilitySliderδα = RandomFloat(minI, maxI);
-	probabilitySliderδβ = RandomFloat(minI, maxI);
-	probabilitySliderδγ = RandomFloat(minI, maxI);
-	probabilitySliderδδ = RandomFloat(minI, maxI);
-	probabilitySliderδε = RandomFloat(minI, maxI);
-	probabilitySliderδζ = RandomFloat(minI, maxI);
-	probabilitySliderδη = RandomFloat(minI, maxI);
-
-	probabilitySliderεα = RandomFloat(minI, maxI);
-	probabilitySliderεβ = RandomFloat(minI, maxI);
-	probabilitySliderεγ = RandomFloat(minI, maxI);
-	probabilitySliderεδ = RandomFloat(minI, maxI);
-	probabilitySliderεε = RandomFloat(minI, maxI);
-	probabilitySliderεζ = RandomFloat(minI, maxI);
-	probabilitySliderεη = RandomFloat(minI, maxI);
-
-	probabilitySliderζα = RandomFloat(minI, maxI);
-	probabilitySliderζβ = RandomFloat(minI, maxI);
-	probabilitySliderζγ = RandomFloat(minI, maxI);
-	probabilitySliderζδ = RandomFloat(minI, maxI);
-	probabilitySliderζε = RandomFloat(minI, maxI);
-	probabilitySliderζζ = RandomFloat(minI, maxI);
-	probabilitySliderζη = RandomFloat(minI, maxI);
-
-	probabilitySliderηα = RandomFloat(minI, maxI);
-	probabilitySliderηβ = RandomFloat(minI, maxI);
-	probabilitySliderηγ = RandomFloat(minI, maxI);
-	probabilitySliderηδ = RandomFloat(minI, maxI);
-	probabilitySliderηε = RandomFloat(minI, maxI);
-	probabilitySliderηζ = RandomFloat(minI, maxI);
-	probabilitySliderηη = RandomFloat(minI, maxI);
-
-	probabilitySliderαθ = RandomFloat(minI, maxI);
-	probabilitySliderβθ = RandomFloat(minI, maxI);
-	probabilitySliderγθ = RandomFloat(minI, maxI);
-	probabilitySliderδθ = RandomFloat(minI, maxI);
-	probabilitySliderεθ = RandomFloat(minI, maxI);
-	probabilitySliderζθ = RandomFloat(minI, maxI);
-	probabilitySliderηθ = RandomFloat(minI, maxI);
-	probabilitySliderθα = RandomFloat(minI, maxI);
-	probabilitySliderθβ = RandomFloat(minI, maxI);
-	probabilitySliderθγ = RandomFloat(minI, maxI);
-	probabilitySliderθδ = RandomFloat(minI, maxI);
-	probabilitySliderθε = RandomFloat(minI, maxI);
-	probabilitySliderθζ = RandomFloat(minI, maxI);
-	probabilitySliderθη = RandomFloat(minI, maxI);
-	probabilitySliderθθ = RandomFloat(minI, maxI);
-
-	// Alpha
-	//numberSliderα = RandomFloat(minR, 3000);
-	powerSliderαα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderαβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Betha
-	//numberSliderβ = RandomFloat(minR, 3000);
-	powerSliderββ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderββ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Gamma
-	//numberSliderγ = RandomFloat(minR, 3000);
-	powerSliderγγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderγβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Delta
-	// numberSliderδ = RandomFloat(minR, 3000);
-	powerSliderδδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderδβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Epsilon
-	//numberSliderε = RandomFloat(minR, 3000);
-	powerSliderεγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderεβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Zeta
-	//numberSliderζ = RandomFloat(minR, 3000);
-	powerSliderζγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderζβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Etha
-	//numberSliderη = RandomFloat(minR, 3000);
-	powerSliderηγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderηβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Tetha
-	//numberSliderθ = RandomFloat(minR, 3000);
-	powerSliderθγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderθβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθη = RandomFloat(minR, maxR) * radiusVariance;
-
-	powerSliderγθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθθ = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderβθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθθ = RandomFloat(minR, maxR) * radiusVariance;
+	simulationModel model = currentModel();
+	randomizeRelations(model, rng, forceVariance, radiusVariance);
+	applyModel(model);
 }
-void ofApp::monads() {
-	numberSliderβ = RandomInt(500, 2000);
-	numberSliderα = RandomInt(500, 2000);
-	numberSliderδ = RandomInt(500, 2000);
-	numberSliderγ = RandomInt(500, 2000);
-	numberSliderε = RandomInt(500, 2000);
-	numberSliderζ = RandomInt(500, 2000);
-	numberSliderη = RandomInt(500, 2000);
-	numberSliderθ = RandomInt(500, 2000);
+void ofApp::monads()
+{
+	simulationModel model = currentModel();
+	randomizeCounts(model, rng);
+	applyModel(model);
 }
-void ofApp::rndvsc() {
-	viscositySlider = RandomFloat(minV, maxV);
-
-	viscositySliderαα = RandomFloat(minV, maxV);
-	viscositySliderαβ = RandomFloat(minV, maxV);
-	viscositySliderαδ = RandomFloat(minV, maxV);
-	viscositySliderαγ = RandomFloat(minV, maxV);
-	viscositySliderαε = RandomFloat(minV, maxV);
-	viscositySliderαζ = RandomFloat(minV, maxV);
-	viscositySliderαη = RandomFloat(minV, maxV);
-
-	viscositySliderβα = RandomFloat(minV, maxV);
-	viscositySliderββ = RandomFloat(minV, maxV);
-	viscositySliderβδ = RandomFloat(minV, maxV);
-	viscositySliderβγ = RandomFloat(minV, maxV);
-	viscositySliderβε = RandomFloat(minV, maxV);
-	viscositySliderβζ = RandomFloat(minV, maxV);
-	viscositySliderβη = RandomFloat(minV, maxV);
-
-	viscositySliderγα = RandomFloat(minV, maxV);
-	viscositySliderγβ = RandomFloat(minV, maxV);
-	viscositySliderγδ = RandomFloat(minV, maxV);
-	viscositySliderγγ = RandomFloat(minV, maxV);
-	viscositySliderγε = RandomFloat(minV, maxV);
-	viscositySliderγζ = RandomFloat(minV, maxV);
-	viscositySliderγη = RandomFloat(minV, maxV);
-
-	viscositySliderδα = RandomFloat(minV, maxV);
-	viscositySliderδβ = RandomFloat(minV, maxV);
-	viscositySliderδδ = RandomFloat(minV, maxV);
-	viscositySliderδγ = RandomFloat(minV, maxV);
-	viscositySliderδε = RandomFloat(minV, maxV);
-	viscositySliderδζ = RandomFloat(minV, maxV);
-	viscositySliderδη = RandomFloat(minV, maxV);
-
-	viscositySliderεα = RandomFloat(minV, maxV);
-	viscositySliderεβ = RandomFloat(minV, maxV);
-	viscositySliderεδ = RandomFloat(minV, maxV);
-	viscositySliderεγ = RandomFloat(minV, maxV);
-	viscositySliderεε = RandomFloat(minV, maxV);
-	viscositySliderεζ = RandomFloat(minV, maxV);
-	viscositySliderεη = RandomFloat(minV, maxV);
-
-	viscositySliderζα = RandomFloat(minV, maxV);
-	viscositySliderζβ = RandomFloat(minV, maxV);
-	viscositySliderζδ = RandomFloat(minV, maxV);
-	viscositySliderζγ = RandomFloat(minV, maxV);
-	viscositySliderζε = RandomFloat(minV, maxV);
-	viscositySliderζζ = RandomFloat(minV, maxV);
-	viscositySliderζη = RandomFloat(minV, maxV);
-
-	viscositySliderηα = RandomFloat(minV, maxV);
-	viscositySliderηβ = RandomFloat(minV, maxV);
-	viscositySliderηδ = RandomFloat(minV, maxV);
-	viscositySliderηγ = RandomFloat(minV, maxV);
-	viscositySliderηε = RandomFloat(minV, maxV);
-	viscositySliderηζ = RandomFloat(minV, maxV);
-	viscositySliderηη = RandomFloat(minV, maxV);
-
-	viscositySliderαθ = RandomFloat(minV, maxV);
-	viscositySliderβθ = RandomFloat(minV, maxV);
-	viscositySliderδθ = RandomFloat(minV, maxV);
-	viscositySliderγθ = RandomFloat(minV, maxV);
-	viscositySliderεθ = RandomFloat(minV, maxV);
-	viscositySliderζθ = RandomFloat(minV, maxV);
-	viscositySliderηθ = RandomFloat(minV, maxV);
-	viscositySliderθα = RandomFloat(minV, maxV);
-	viscositySliderθβ = RandomFloat(minV, maxV);
-	viscositySliderθδ = RandomFloat(minV, maxV);
-	viscositySliderθγ = RandomFloat(minV, maxV);
-	viscositySliderθε = RandomFloat(minV, maxV);
-	viscositySliderθζ = RandomFloat(minV, maxV);
-	viscositySliderθη = RandomFloat(minV, maxV);
-	viscositySliderθθ = RandomFloat(minV, maxV);
+void ofApp::rndvsc()
+{
+	simulationModel model = currentModel();
+	randomizeViscosity(model, rng);
+	applyModel(model);
 }
-void ofApp::rndprob() {
-	probabilitySlider = RandomFloat(minI, maxI);
-
-	probabilitySliderαα = RandomFloat(minI, maxI);
-	probabilitySliderαβ = RandomFloat(minI, maxI);
-	probabilitySliderαγ = RandomFloat(minI, maxI);
-	probabilitySliderαδ = RandomFloat(minI, maxI);
-	probabilitySliderαε = RandomFloat(minI, maxI);
-	probabilitySliderαζ = RandomFloat(minI, maxI);
-	probabilitySliderαη = RandomFloat(minI, maxI);
-
-	probabilitySliderβα = RandomFloat(minI, maxI);
-	probabilitySliderββ = RandomFloat(minI, maxI);
-	probabilitySliderβγ = RandomFloat(minI, maxI);
-	probabilitySliderβδ = RandomFloat(minI, maxI);
-	probabilitySliderβε = RandomFloat(minI, maxI);
-	probabilitySliderβζ = RandomFloat(minI, maxI);
-	probabilitySliderβη = RandomFloat(minI, maxI);
-
-	probabilitySliderγα = RandomFloat(minI, maxI);
-	probabilitySliderγβ = RandomFloat(minI, maxI);
-	probabilitySliderγγ = RandomFloat(minI, maxI);
-	probabilitySliderγδ = RandomFloat(minI, maxI);
-	probabilitySliderγε = RandomFloat(minI, maxI);
-	probabilitySliderγζ = RandomFloat(minI, maxI);
-	probabilitySliderγη = RandomFloat(minI, maxI);
-
-	probabilitySliderδα = RandomFloat(minI, maxI);
-	probabilitySliderδβ = RandomFloat(minI, maxI);
-	probabilitySliderδγ = RandomFloat(minI, maxI);
-	probabilitySliderδδ = RandomFloat(minI, maxI);
-	probabilitySliderδε = RandomFloat(minI, maxI);
-	probabilitySliderδζ = RandomFloat(minI, maxI);
-	probabilitySliderδη = RandomFloat(minI, maxI);
-
-	probabilitySliderεα = RandomFloat(minI, maxI);
-	probabilitySliderεβ = RandomFloat(minI, maxI);
-	probabilitySliderεγ = RandomFloat(minI, maxI);
-	probabilitySliderεδ = RandomFloat(minI, maxI);
-	probabilitySliderεε = RandomFloat(minI, maxI);
-	probabilitySliderεζ = RandomFloat(minI, maxI);
-	probabilitySliderεη = RandomFloat(minI, maxI);
-
-	probabilitySliderζα = RandomFloat(minI, maxI);
-	probabilitySliderζβ = RandomFloat(minI, maxI);
-	probabilitySliderζγ = RandomFloat(minI, maxI);
-	probabilitySliderζδ = RandomFloat(minI, maxI);
-	probabilitySliderζε = RandomFloat(minI, maxI);
-	probabilitySliderζζ = RandomFloat(minI, maxI);
-	probabilitySliderζη = RandomFloat(minI, maxI);
-
-	probabilitySliderηα = RandomFloat(minI, maxI);
-	probabilitySliderηβ = RandomFloat(minI, maxI);
-	probabilitySliderηγ = RandomFloat(minI, maxI);
-	probabilitySliderηδ = RandomFloat(minI, maxI);
-	probabilitySliderηε = RandomFloat(minI, maxI);
-	probabilitySliderηζ = RandomFloat(minI, maxI);
-	probabilitySliderηη = RandomFloat(minI, maxI);
-
-	probabilitySliderαθ = RandomFloat(minI, maxI);
-	probabilitySliderβθ = RandomFloat(minI, maxI);
-	probabilitySliderγθ = RandomFloat(minI, maxI);
-	probabilitySliderδθ = RandomFloat(minI, maxI);
-	probabilitySliderεθ = RandomFloat(minI, maxI);
-	probabilitySliderζθ = RandomFloat(minI, maxI);
-	probabilitySliderηθ = RandomFloat(minI, maxI);
-	probabilitySliderθα = RandomFloat(minI, maxI);
-	probabilitySliderθβ = RandomFloat(minI, maxI);
-	probabilitySliderθγ = RandomFloat(minI, maxI);
-	probabilitySliderθδ = RandomFloat(minI, maxI);
-	probabilitySliderθε = RandomFloat(minI, maxI);
-	probabilitySliderθζ = RandomFloat(minI, maxI);
-	probabilitySliderθη = RandomFloat(minI, maxI);
-	probabilitySliderθθ = RandomFloat(minI, maxI);
+void ofApp::rndprob()
+{
+	simulationModel model = currentModel();
+	randomizeProbability(model, rng);
+	applyModel(model);
 }
-void ofApp::rndir() {
-	// Alpha
-	//numberSliderα = RandomFloat(minR, 3000);
-	powerSliderαα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderαβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Betha
-	//numberSliderβ = RandomFloat(minR, 3000);
-	powerSliderββ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderββ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderβη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Gamma
-	//numberSliderγ = RandomFloat(minR, 3000);
-	powerSliderγγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderγη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderγβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Delta
-	// numberSliderδ = RandomFloat(minR, 3000);
-	powerSliderδδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderδβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Epsilon
-	//numberSliderε = RandomFloat(minR, 3000);
-	powerSliderεγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderεβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Zeta
-	//numberSliderζ = RandomFloat(minR, 3000);
-	powerSliderζγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderζβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Etha
-	//numberSliderη = RandomFloat(minR, 3000);
-	powerSliderηγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderηβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηη = RandomFloat(minR, maxR) * radiusVariance;
-
-	// Tetha
-	//numberSliderθ = RandomFloat(minR, 3000);
-	powerSliderθγ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθδ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθα = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθβ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθε = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθζ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθη = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderθβ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθα = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθδ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθγ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθε = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθζ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθη = RandomFloat(minR, maxR) * radiusVariance;
-
-	powerSliderγθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderδθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderαθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderβθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderεθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderζθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderηθ = RandomFloat(minP, maxP) * forceVariance;
-	powerSliderθθ = RandomFloat(minP, maxP) * forceVariance;
-
-	vSliderβθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderαθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderδθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderγθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderεθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderζθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderηθ = RandomFloat(minR, maxR) * radiusVariance;
-	vSliderθθ = RandomFloat(minR, maxR) * radiusVariance;
+void ofApp::rndir()
+{
+	simulationModel model = currentModel();
+	randomizeInteractions(model, rng, forceVariance, radiusVariance);
+	applyModel(model);
 }
-void ofApp::freeze() {
-	InteractionEvoProbSlider = 0.3;
-	InteractionEvoAmountSlider = 0.3;
-	ProbabilityEvoProbSlider = 0.2;
-	ProbabilityEvoAmountSlider = 0.2;
-	ViscosityEvoProbSlider = 0.1;
-	ViscosityEvoAmountSlider = 0.1;
-
-	viscositySlider = 100;
-
-	viscositySliderαα = 100;
-	viscositySliderαβ = 100;
-	viscositySliderαδ = 100;
-	viscositySliderαγ = 100;
-	viscositySliderαε = 100;
-	viscositySliderαζ = 100;
-	viscositySliderαη = 100;
-
-	viscositySliderβα = 100;
-	viscositySliderββ = 100;
-	viscositySliderβδ = 100;
-	viscositySliderβγ = 100;
-	viscositySliderβε = 100;
-	viscositySliderβζ = 100;
-	viscositySliderβη = 100;
-
-	viscositySliderγα = 100;
-	viscositySliderγβ = 100;
-	viscositySliderγδ = 100;
-	viscositySliderγγ = 100;
-	viscositySliderγε = 100;
-	viscositySliderγζ = 100;
-	viscositySliderγη = 100;
-
-	viscositySliderδα = 100;
-	viscositySliderδβ = 100;
-	viscositySliderδδ = 100;
-	viscositySliderδγ = 100;
-	viscositySliderδε = 100;
-	viscositySliderδζ = 100;
-	viscositySliderδη = 100;
-
-	viscositySliderεα = 100;
-	viscositySliderεβ = 100;
-	viscositySliderεδ = 100;
-	viscositySliderεγ = 100;
-	viscositySliderεε = 100;
-	viscositySliderεζ = 100;
-	viscositySliderεη = 100;
-
-	viscositySliderζα = 100;
-	viscositySliderζβ = 100;
-	viscositySliderζδ = 100;
-	viscositySliderζγ = 100;
-	viscositySliderζε = 100;
-	viscositySliderζζ = 100;
-	viscositySliderζη = 100;
-
-	viscositySliderηα = 100;
-	viscositySliderηβ = 100;
-	viscositySliderηδ = 100;
-	viscositySliderηγ = 100;
-	viscositySliderηε = 100;
-	viscositySliderηζ = 100;
-	viscositySliderηη = 100;
-
-	viscositySliderαθ = 100;
-	viscositySliderβθ = 100;
-	viscositySliderδθ = 100;
-	viscositySliderγθ = 100;
-	viscositySliderεθ = 100;
-	viscositySliderζθ = 100;
-	viscositySliderηθ = 100;
-	viscositySliderθα = 100;
-	viscositySliderθβ = 100;
-	viscositySliderθδ = 100;
-	viscositySliderθγ = 100;
-	viscositySliderθε = 100;
-	viscositySliderθζ = 100;
-	viscositySliderθη = 100;
-	viscositySliderθθ = 100;
-
-	probabilitySlider = 0;
-
-	probabilitySliderαα = 0;
-	probabilitySliderαβ = 0;
-	probabilitySliderαγ = 0;
-	probabilitySliderαδ = 0;
-	probabilitySliderαε = 0;
-	probabilitySliderαζ = 0;
-	probabilitySliderαη = 0;
-
-	probabilitySliderβα = 0;
-	probabilitySliderββ = 0;
-	probabilitySliderβγ = 0;
-	probabilitySliderβδ = 0;
-	probabilitySliderβε = 0;
-	probabilitySliderβζ = 0;
-	probabilitySliderβη = 0;
-
-	probabilitySliderγα = 0;
-	probabilitySliderγβ = 0;
-	probabilitySliderγγ = 0;
-	probabilitySliderγδ = 0;
-	probabilitySliderγε = 0;
-	probabilitySliderγζ = 0;
-	probabilitySliderγη = 0;
-
-	probabilitySliderδα = 0;
-	probabilitySliderδβ = 0;
-	probabilitySliderδγ = 0;
-	probabilitySliderδδ = 0;
-	probabilitySliderδε = 0;
-	probabilitySliderδζ = 0;
-	probabilitySliderδη = 0;
-
-	probabilitySliderεα = 0;
-	probabilitySliderεβ = 0;
-	probabilitySliderεγ = 0;
-	probabilitySliderεδ = 0;
-	probabilitySliderεε = 0;
-	probabilitySliderεζ = 0;
-	probabilitySliderεη = 0;
-
-	probabilitySliderζα = 0;
-	probabilitySliderζβ = 0;
-	probabilitySliderζγ = 0;
-	probabilitySliderζδ = 0;
-	probabilitySliderζε = 0;
-	probabilitySliderζζ = 0;
-	probabilitySliderζη = 0;
-
-	probabilitySliderηα = 0;
-	probabilitySliderηβ = 0;
-	probabilitySliderηγ = 0;
-	probabilitySliderηδ = 0;
-	probabilitySliderηε = 0;
-	probabilitySliderηζ = 0;
-	probabilitySliderηη = 0;
-
-	probabilitySliderαθ = 0;
-	probabilitySliderβθ = 0;
-	probabilitySliderγθ = 0;
-	probabilitySliderδθ = 0;
-	probabilitySliderεθ = 0;
-	probabilitySliderζθ = 0;
-	probabilitySliderηθ = 0;
-	probabilitySliderθα = 0;
-	probabilitySliderθβ = 0;
-	probabilitySliderθγ = 0;
-	probabilitySliderθδ = 0;
-	probabilitySliderθε = 0;
-	probabilitySliderθζ = 0;
-	probabilitySliderθη = 0;
-	probabilitySliderθθ = 0;
-
-	// Betha
-
-	powerSliderββ = 0;
-	powerSliderβα = 0;
-	powerSliderβδ = 0;
-	powerSliderβγ = 0;
-	powerSliderβε = 0;
-	powerSliderβζ = 0;
-	powerSliderβη = 0;
-
-	vSliderββ = 0;
-	vSliderβα = 0;
-	vSliderβδ = 0;
-	vSliderβγ = 0;
-	vSliderβε = 0;
-	vSliderβζ = 0;
-	vSliderβη = 0;
-
-	// Alpha
-	
-	powerSliderαα = 0;
-	powerSliderαβ = 0;
-	powerSliderαδ = 0;
-	powerSliderαγ = 0;
-	powerSliderαε = 0;
-	powerSliderαζ = 0;
-	powerSliderαη = 0;
-
-	vSliderαβ = 0;
-	vSliderαα = 0;
-	vSliderαδ = 0;
-	vSliderαγ = 0;
-	vSliderαε = 0;
-	vSliderαζ = 0;
-	vSliderαη = 0;
-
-	// Delta
-	
-	powerSliderδδ = 0;
-	powerSliderδα = 0;
-	powerSliderδβ = 0;
-	powerSliderδγ = 0;
-	powerSliderδε = 0;
-	powerSliderδζ = 0;
-	powerSliderδη = 0;
-
-	vSliderδβ = 0;
-	vSliderδα = 0;
-	vSliderδδ = 0;
-	vSliderδγ = 0;
-	vSliderδε = 0;
-	vSliderδζ = 0;
-	vSliderδη = 0;
-
-	// Gamma
-	
-	powerSliderγγ = 0;
-	powerSliderγδ = 0;
-	powerSliderγα = 0;
-	powerSliderγβ = 0;
-	powerSliderγε = 0;
-	powerSliderγζ = 0;
-	powerSliderγη = 0;
-
-	vSliderγβ = 0;
-	vSliderγα = 0;
-	vSliderγδ = 0;
-	vSliderγγ = 0;
-	vSliderγε = 0;
-	vSliderγζ = 0;
-	vSliderγη = 0;
-
-	// Epsilon
-	
-	powerSliderεγ = 0;
-	powerSliderεδ = 0;
-	powerSliderεα = 0;
-	powerSliderεβ = 0;
-	powerSliderεε = 0;
-	powerSliderεζ = 0;
-	powerSliderεη = 0;
-
-	vSliderεβ = 0;
-	vSliderεα = 0;
-	vSliderεδ = 0;
-	vSliderεγ = 0;
-	vSliderεε = 0;
-	vSliderεζ = 0;
-	vSliderεη = 0;
-
-	// Zetha
-	
-	powerSliderζγ = 0;
-	powerSliderζδ = 0;
-	powerSliderζα = 0;
-	powerSliderζβ = 0;
-	powerSliderζε = 0;
-	powerSliderζζ = 0;
-	powerSliderζη = 0;
-
-	vSliderζβ = 0;
-	vSliderζα = 0;
-	vSliderζδ = 0;
-	vSliderζγ = 0;
-	vSliderζε = 0;
-	vSliderζζ = 0;
-	vSliderζη = 0;
-
-	// Etha
-	
-	powerSliderηγ = 0;
-	powerSliderηδ = 0;
-	powerSliderηα = 0;
-	powerSliderηβ = 0;
-	powerSliderηε = 0;
-	powerSliderηζ = 0;
-	powerSliderηη = 0;
-
-	vSliderηβ = 0;
-	vSliderηα = 0;
-	vSliderηδ = 0;
-	vSliderηγ = 0;
-	vSliderηε = 0;
-	vSliderηζ = 0;
-	vSliderηη = 0;
-
-	// Etha
-
-	powerSliderθγ = 0;
-	powerSliderθδ = 0;
-	powerSliderθα = 0;
-	powerSliderθβ = 0;
-	powerSliderθε = 0;
-	powerSliderθζ = 0;
-	powerSliderθη = 0;
-	powerSliderθθ = 0;
-
-	vSliderθβ = 0;
-	vSliderθα = 0;
-	vSliderθδ = 0;
-	vSliderθγ = 0;
-	vSliderθε = 0;
-	vSliderθζ = 0;
-	vSliderθη = 0;
-	vSliderθθ = 0;
-
-	powerSliderγθ = 0;
-	powerSliderδθ = 0;
-	powerSliderαθ = 0;
-	powerSliderβθ = 0;
-	powerSliderεθ = 0;
-	powerSliderζθ = 0;
-	powerSliderηθ = 0;
-
-	vSliderβθ = 0;
-	vSliderαθ = 0;
-	vSliderδθ = 0;
-	vSliderγθ = 0;
-	vSliderεθ = 0;
-	vSliderζθ = 0;
-	vSliderηθ = 0;
+void ofApp::freeze()
+{
+	simulationModel model = currentModel();
+	freezeModel(model);
+	applyModel(model);
 }
 
 /// this is a cheap and quick way to save and load parameters (openFramework have betters ways but requires some additional library setups) 
 // Dialog gui tested on windows machine only. Not sure if it works on Mac or Linux too.
 void ofApp::saveSettings()
 {
-	const std::vector<float> settings = {
-		powerSliderββ, powerSliderβα, powerSliderβδ, powerSliderβγ, powerSliderβε, powerSliderβζ, powerSliderβη,
-		vSliderββ, vSliderβα, vSliderβδ, vSliderβγ, vSliderβε, vSliderβζ, vSliderβη,
-		powerSliderαβ, powerSliderαα, powerSliderαδ, powerSliderαγ, powerSliderαε, powerSliderαζ, powerSliderαη,
-		vSliderαβ, vSliderαα, vSliderαδ, vSliderαγ, vSliderαε, vSliderαζ, vSliderαη,
-		powerSliderδβ, powerSliderδα, powerSliderδδ, powerSliderδγ, powerSliderδε, powerSliderδζ, powerSliderδη,
-		vSliderδβ, vSliderδα, vSliderδδ, vSliderδγ, vSliderδε, vSliderδζ, vSliderδη,
-		powerSliderγβ, powerSliderγα, powerSliderγδ, powerSliderγγ, powerSliderγε, powerSliderγζ, powerSliderγη,
-		vSliderγβ, vSliderγα, vSliderγδ, vSliderγγ, vSliderγε, vSliderγζ, vSliderγη,
-		powerSliderεβ, powerSliderεα, powerSliderεδ, powerSliderεγ, powerSliderεε, powerSliderεζ, powerSliderεη,
-		vSliderεβ, vSliderεα, vSliderεδ, vSliderεγ, vSliderεε, vSliderεζ, vSliderεη,
-		powerSliderζβ, powerSliderζα, powerSliderζδ, powerSliderζγ, powerSliderζε, powerSliderζζ, powerSliderζη,
-		vSliderζβ, vSliderζα, vSliderζδ, vSliderζγ, vSliderζε, vSliderζζ, vSliderζη,
-		powerSliderηβ, powerSliderηα, powerSliderηδ, powerSliderηγ, powerSliderηε, powerSliderηζ, powerSliderηη,
-		vSliderηβ, vSliderηα, vSliderηδ, vSliderηγ, vSliderηε, vSliderηζ, vSliderηη,
-		static_cast<float>(numberSliderβ),
-		static_cast<float>(numberSliderα),
-		static_cast<float>(numberSliderδ),
-		static_cast<float>(numberSliderγ),
-		static_cast<float>(numberSliderε),
-		static_cast<float>(numberSliderζ),
-		static_cast<float>(numberSliderη),
-		viscositySlider,
-		viscositySliderαα,
-		viscositySliderαβ,
-		viscositySliderαγ,
-		viscositySliderαδ,
-		viscositySliderαε,
-		viscositySliderαζ,
-		viscositySliderαη,
-		viscositySliderβα,
-		viscositySliderββ,
-		viscositySliderβγ,
-		viscositySliderβδ,
-		viscositySliderβε,
-		viscositySliderβζ,
-		viscositySliderβη,
-		viscositySliderγα,
-		viscositySliderγβ,
-		viscositySliderγγ,
-		viscositySliderγδ,
-		viscositySliderγε,
-		viscositySliderγζ,
-		viscositySliderγη,
-		viscositySliderδα,
-		viscositySliderδβ,
-		viscositySliderδγ,
-		viscositySliderδδ,
-		viscositySliderδε,
-		viscositySliderδζ,
-		viscositySliderδη,
-		viscositySliderεα,
-		viscositySliderεβ,
-		viscositySliderεγ,
-		viscositySliderεδ,
-		viscositySliderεε,
-		viscositySliderεζ,
-		viscositySliderεη,
-		viscositySliderζα,
-		viscositySliderζβ,
-		viscositySliderζγ,
-		viscositySliderζδ,
-		viscositySliderζε,
-		viscositySliderζζ,
-		viscositySliderζη,
-		viscositySliderηα,
-		viscositySliderηβ,
-		viscositySliderηγ,
-		viscositySliderηδ,
-		viscositySliderηε,
-		viscositySliderηζ,
-		viscositySliderηη,
-		InteractionEvoProbSlider,
-		InteractionEvoAmountSlider,
-		probabilitySlider,
-		probabilitySliderαα,
-		probabilitySliderαβ,
-		probabilitySliderαγ,
-		probabilitySliderαδ,
-		probabilitySliderαε,
-		probabilitySliderαζ,
-		probabilitySliderαη,
-		probabilitySliderβα,
-		probabilitySliderββ,
-		probabilitySliderβγ,
-		probabilitySliderβδ,
-		probabilitySliderβε,
-		probabilitySliderβζ,
-		probabilitySliderβη,
-		probabilitySliderγα,
-		probabilitySliderγβ,
-		probabilitySliderγγ,
-		probabilitySliderγδ,
-		probabilitySliderγε,
-		probabilitySliderγζ,
-		probabilitySliderγη,
-		probabilitySliderδα,
-		probabilitySliderδβ,
-		probabilitySliderδγ,
-		probabilitySliderδδ,
-		probabilitySliderδε,
-		probabilitySliderδζ,
-		probabilitySliderδη,
-		probabilitySliderεα,
-		probabilitySliderεβ,
-		probabilitySliderεγ,
-		probabilitySliderεδ,
-		probabilitySliderεε,
-		probabilitySliderεζ,
-		probabilitySliderεη,
-		probabilitySliderζα,
-		probabilitySliderζβ,
-		probabilitySliderζγ,
-		probabilitySliderζδ,
-		probabilitySliderζε,
-		probabilitySliderζζ,
-		probabilitySliderζη,
-		probabilitySliderηα,
-		probabilitySliderηβ,
-		probabilitySliderηγ,
-		probabilitySliderηδ,
-		probabilitySliderηε,
-		probabilitySliderηζ,
-		probabilitySliderηη,
-		minPowerSlider,
-		maxPowerSlider,
-		minRangeSlider,
-		maxRangeSlider,
-		ProbabilityEvoProbSlider,
-		ProbabilityEvoAmountSlider,
-		ViscosityEvoProbSlider,
-		ViscosityEvoAmountSlider,
-		viscositySliderαθ,
-		viscositySliderβθ,
-		viscositySliderγθ,
-		viscositySliderδθ,
-		viscositySliderεθ,
-		viscositySliderζθ,
-		viscositySliderηθ,
-		viscositySliderθα,
-		viscositySliderθβ,
-		viscositySliderθγ,
-		viscositySliderθδ,
-		viscositySliderθε,
-		viscositySliderθζ,
-		viscositySliderθη,
-		viscositySliderθθ,
-		probabilitySliderαθ,
-		probabilitySliderβθ,
-		probabilitySliderγθ,
-		probabilitySliderδθ,
-		probabilitySliderεθ,
-		probabilitySliderζθ,
-		probabilitySliderηθ,
-		probabilitySliderθα,
-		probabilitySliderθβ,
-		probabilitySliderθγ,
-		probabilitySliderθδ,
-		probabilitySliderθε,
-		probabilitySliderθζ,
-		probabilitySliderθη,
-		probabilitySliderθθ,
-		static_cast<float>(numberSliderθ),
-		powerSliderαθ,
-		powerSliderβθ,
-		powerSliderδθ,
-		powerSliderγθ,
-		powerSliderεθ,
-		powerSliderζθ,
-		powerSliderηθ,
-		powerSliderθα,
-		powerSliderθβ,
-		powerSliderθδ,
-		powerSliderθγ,
-		powerSliderθε,
-		powerSliderθζ,
-		powerSliderθη,
-		powerSliderθθ,
-		vSliderαθ,
-		vSliderβθ,
-		vSliderδθ,
-		vSliderγθ,
-		vSliderεθ,
-		vSliderζθ,
-		vSliderηθ,
-		vSliderθα,
-		vSliderθβ,
-		vSliderθδ,
-		vSliderθγ,
-		vSliderθε,
-		vSliderθζ,
-		vSliderθη,
-		vSliderθθ,
-		minViscoSlider,
-		maxViscoSlider,
-		minProbSlider,
-		maxProbSlider,
-	};
-
 	std::string save_path;
 	ofFileDialogResult result = ofSystemSaveDialog("model.txt", "Save");
 	if (result.bSuccess)
@@ -1705,14 +194,8 @@ void ofApp::saveSettings()
 	{
 		ofSystemAlertDialog("Could not Save Model!");
 	}
-	ofstream myfile(save_path);
-	if (myfile.is_open())
+	if (saveModel(save_path, currentModel()))
 	{
-		for (int i = 0; i < settings.size(); i++)
-		{
-			myfile << settings[i] << " ";
-		}
-		myfile.close();
 		std::cout << "file saved successfully";
 	}
 	else
@@ -1721,328 +204,88 @@ void ofApp::saveSettings()
 	}
 }
 
-// Dialog gui tested on windows machine only. Not sure if it works on Mac or Linux too.
-void ofApp::loadSettings()
+/**
+ * @brief Model made of the current slider values
+ */
+simulationModel ofApp::currentModel()
 {
-	std::string load_path;
-	std::string text;
-	ofFileDialogResult result = ofSystemLoadDialog("Load file", false, load_path);
-	if (result.bSuccess)
+	simulationModel model;
+	for (auto k = 0; k < TYPE_COUNT * TYPE_COUNT; k++)
 	{
-		load_path = result.getPath();
-		std::ifstream t(load_path);
-		std::stringstream loaded;
-		loaded << t.rdbuf();
-		text = loaded.str();
+		model.matrix.power[k / TYPE_COUNT][k % TYPE_COUNT] = *powersliders[k];
+		model.matrix.radius[k / TYPE_COUNT][k % TYPE_COUNT] = *vsliders[k];
+		model.matrix.viscosity[k / TYPE_COUNT][k % TYPE_COUNT] = *viscositysliders[k];
+		model.matrix.probability[k / TYPE_COUNT][k % TYPE_COUNT] = *probabilitysliders[k];
 	}
-	else
+	for (auto t = 0; t < TYPE_COUNT; t++) model.count[t] = *numbersliders[t];
+	model.viscosity = viscositySlider;
+	model.probability = probabilitySlider;
+	model.minPower = minPowerSlider;
+	model.maxPower = maxPowerSlider;
+	model.minRange = minRangeSlider;
+	model.maxRange = maxRangeSlider;
+	model.minViscosity = minViscoSlider;
+	model.maxViscosity = maxViscoSlider;
+	model.minProbability = minProbSlider;
+	model.maxProbability = maxProbSlider;
+	model.interactionEvoChance = InteractionEvoProbSlider;
+	model.interactionEvoAmount = InteractionEvoAmountSlider;
+	model.probabilityEvoChance = ProbabilityEvoProbSlider;
+	model.probabilityEvoAmount = ProbabilityEvoAmountSlider;
+	model.viscosityEvoChance = ViscosityEvoProbSlider;
+	model.viscosityEvoAmount = ViscosityEvoAmountSlider;
+	return model;
+}
+
+/**
+ * @brief Move the sliders to the values of a model
+ */
+void ofApp::applyModel(const simulationModel& model)
+{
+	for (auto k = 0; k < TYPE_COUNT * TYPE_COUNT; k++)
 	{
-		ofSystemAlertDialog("Could not Load the File!");
+		*powersliders[k] = model.matrix.power[k / TYPE_COUNT][k % TYPE_COUNT];
+		*vsliders[k] = model.matrix.radius[k / TYPE_COUNT][k % TYPE_COUNT];
+		*viscositysliders[k] = model.matrix.viscosity[k / TYPE_COUNT][k % TYPE_COUNT];
+		*probabilitysliders[k] = model.matrix.probability[k / TYPE_COUNT][k % TYPE_COUNT];
 	}
+	for (auto t = 0; t < TYPE_COUNT; t++) *numbersliders[t] = model.count[t];
+	viscositySlider = model.viscosity;
+	probabilitySlider = model.probability;
+	minPowerSlider = model.minPower;
+	maxPowerSlider = model.maxPower;
+	minRangeSlider = model.minRange;
+	maxRangeSlider = model.maxRange;
+	minViscoSlider = model.minViscosity;
+	maxViscoSlider = model.maxViscosity;
+	minProbSlider = model.minProbability;
+	maxProbSlider = model.maxProbability;
+	InteractionEvoProbSlider = model.interactionEvoChance;
+	InteractionEvoAmountSlider = model.interactionEvoAmount;
+	ProbabilityEvoProbSlider = model.probabilityEvoChance;
+	ProbabilityEvoAmountSlider = model.probabilityEvoAmount;
+	ViscosityEvoProbSlider = model.viscosityEvoChance;
+	ViscosityEvoAmountSlider = model.viscosityEvoAmount;
+}
 
-	// split text by space and convert them to floats
-	string word;
-	std::vector<float> p;
-	for (auto x : text)
+// Dialog gui tested on windows machine only. Not sure if it works on Mac or Linux too.
+void ofApp::loadSettings()
+{
+	std::string load_path;
+	ofFileDialogResult result = ofSystemLoadDialog("Load file", false, load_path);
+	simulationModel model;
+	if (!result.bSuccess)
 	{
-		if (x == ' ')
-		{
-			p.push_back(std::stof(word));
-			word = "";
-		}
-		else
-		{
-			word += x;
-		}
+		ofSystemAlertDialog("Could not Load the File!");
 	}
-
-	if (p.size() < 280)
+	else if (!loadModel(result.getPath(), model))
 	{
 		// better checks needed
 		ofSystemAlertDialog("Could not read the file!");
 	}
 	else
 	{
-		powerSliderββ = p[0];
-		powerSliderβα = p[1];
-		powerSliderβδ = p[2];
-		powerSliderβγ = p[3];
-		powerSliderβε = p[4];
-		powerSliderβζ = p[5];
-		powerSliderβη = p[6];
-		vSliderββ = p[7];
-		vSliderβα = p[8];
-		vSliderβδ = p[9];
-		vSliderβγ = p[10];
-		vSliderβε = p[11];
-		vSliderβζ = p[12];
-		vSliderβη = p[13];
-		powerSliderαβ = p[14];
-		powerSliderαα = p[15];
-		powerSliderαδ = p[16];
-		powerSliderαγ = p[17];
-		powerSliderαε = p[18];
-		powerSliderαζ = p[19];
-		powerSliderαη = p[20];
-		vSliderαβ = p[21];
-		vSliderαα = p[22];
-		vSliderαδ = p[23];
-		vSliderαγ = p[24];
-		vSliderαε = p[25];
-		vSliderαζ = p[26];
-		vSliderαη = p[27];
-		powerSliderδβ = p[28];
-		powerSliderδα = p[29];
-		powerSliderδδ = p[30];
-		powerSliderδγ = p[31];
-		powerSliderδε = p[32];
-		powerSliderδζ = p[33];
-		powerSliderδη = p[34];
-		vSliderδβ = p[35];
-		vSliderδα = p[36];
-		vSliderδδ = p[37];
-		vSliderδγ = p[38];
-		vSliderδε = p[39];
-		vSliderδζ = p[40];
-		vSliderδη = p[41];
-		powerSliderγβ = p[42];
-		powerSliderγα = p[43];
-		powerSliderγδ = p[44];
-		powerSliderγγ = p[45];
-		powerSliderγε = p[46];
-		powerSliderγζ = p[47];
-		powerSliderγη = p[48];
-		vSliderγβ = p[49];
-		vSliderγα = p[50];
-		vSliderγδ = p[51];
-		vSliderγγ = p[52];
-		vSliderγε = p[53];
-		vSliderγζ = p[54];
-		vSliderγη = p[55];
-		powerSliderεβ = p[56];
-		powerSliderεα = p[57];
-		powerSliderεδ = p[58];
-		powerSliderεγ = p[59];
-		powerSliderεε = p[60];
-		powerSliderεζ = p[61];
-		powerSliderεη = p[62];
-		vSliderεβ = p[63];
-		vSliderεα = p[64];
-		vSliderεδ = p[65];
-		vSliderεγ = p[66];
-		vSliderεε = p[67];
-		vSliderεζ = p[68];
-		vSliderεη = p[69];
-		powerSliderζβ = p[70];
-		powerSliderζα = p[71];
-		powerSliderζδ = p[72];
-		powerSliderζγ = p[73];
-		powerSliderζε = p[74];
-		powerSliderζζ = p[75];
-		powerSliderζη = p[76];
-		vSliderζβ = p[77];
-		vSliderζα = p[78];
-		vSliderζδ = p[79];
-		vSliderζγ = p[80];
-		vSliderζε = p[81];
-		vSliderζζ = p[82];
-		vSliderζη = p[83];
-		powerSliderηβ = p[84];
-		powerSliderηα = p[85];
-		powerSliderηδ = p[86];
-		powerSliderηγ = p[87];
-		powerSliderηε = p[88];
-		powerSliderηζ = p[89];
-		powerSliderηη = p[90];
-		vSliderηβ = p[91];
-		vSliderηα = p[92];
-		vSliderηδ = p[93];
-		vSliderηγ = p[94];
-		vSliderηε = p[95];
-		vSliderηζ = p[96];
-		vSliderηη = p[97];
-		numberSliderβ = static_cast<int>(p[98]);
-		numberSliderα = static_cast<int>(p[99]);
-		numberSliderδ = static_cast<int>(p[100]);
-		numberSliderγ = static_cast<int>(p[101]);
-		numberSliderε = static_cast<int>(p[102]);
-		numberSliderζ = static_cast<int>(p[103]);
-		numberSliderη = static_cast<int>(p[104]);
-		viscositySlider = p[105];
-		viscositySliderαα = p[106];
-		viscositySliderαβ = p[107];
-		viscositySliderαγ = p[108];
-		viscositySliderαδ = p[109];
-		viscositySliderαε = p[110];
-		viscositySliderαζ = p[111];
-		viscositySliderαη = p[112];
-		viscositySliderβα = p[113];
-		viscositySliderββ = p[114];
-		viscositySliderβγ = p[115];
-		viscositySliderβδ = p[116];
-		viscositySliderβε = p[117];
-		viscositySliderβζ = p[118];
-		viscositySliderβη = p[119];
-		viscositySliderγα = p[120];
-		viscositySliderγβ = p[121];
-		viscositySliderγγ = p[122];
-		viscositySliderγδ = p[123];
-		viscositySliderγε = p[124];
-		viscositySliderγζ = p[125];
-		viscositySliderγη = p[126];
-		viscositySliderδα = p[127];
-		viscositySliderδβ = p[128];
-		viscositySliderδγ = p[129];
-		viscositySliderδδ = p[130];
-		viscositySliderδε = p[131];
-		viscositySliderδζ = p[132];
-		viscositySliderδη = p[133];
-		viscositySliderεα = p[134];
-		viscositySliderεβ = p[135];
-		viscositySliderεγ = p[136];
-		viscositySliderεδ = p[137];
-		viscositySliderεε = p[138];
-		viscositySliderεζ = p[139];
-		viscositySliderεη = p[140];
-		viscositySliderζα = p[141];
-		viscositySliderζβ = p[142];
-		viscositySliderζγ = p[143];
-		viscositySliderζδ = p[144];
-		viscositySliderζε = p[145];
-		viscositySliderζζ = p[146];
-		viscositySliderζη = p[147];
-		viscositySliderηα = p[148];
-		viscositySliderηβ = p[149];
-		viscositySliderηγ = p[150];
-		viscositySliderηδ = p[151];
-		viscositySliderηε = p[152];
-		viscositySliderηζ = p[153];
-		viscositySliderηη = p[154];
-		InteractionEvoProbSlider = p[155];
-		InteractionEvoAmountSlider = p[156];
-		probabilitySlider = p[157];
-		probabilitySliderαα = p[158];
-		probabilitySliderαβ = p[159];
-		probabilitySliderαγ = p[160];
-		probabilitySliderαδ = p[161];
-		probabilitySliderαε = p[162];
-		probabilitySliderαζ = p[163];
-		probabilitySliderαη = p[164];
-		probabilitySliderβα = p[165];
-		probabilitySliderββ = p[166];
-		probabilitySliderβγ = p[167];
-		probabilitySliderβδ = p[168];
-		probabilitySliderβε = p[169];
-		probabilitySliderβζ = p[170];
-		probabilitySliderβη = p[171];
-		probabilitySliderγα = p[172];
-		probabilitySliderγβ = p[173];
-		probabilitySliderγγ = p[174];
-		probabilitySliderγδ = p[175];
-		probabilitySliderγε = p[176];
-		probabilitySliderγζ = p[177];
-		probabilitySliderγη = p[178];
-		probabilitySliderδα = p[179];
-		probabilitySliderδβ = p[180];
-		probabilitySliderδγ = p[181];
-		probabilitySliderδδ = p[182];
-		probabilitySliderδε = p[183];
-		probabilitySliderδζ = p[184];
-		probabilitySliderδη = p[185];
-		probabilitySliderεα = p[186];
-		probabilitySliderεβ = p[187];
-		probabilitySliderεγ = p[188];
-		probabilitySliderεδ = p[189];
-		probabilitySliderεε = p[190];
-		probabilitySliderεζ = p[191];
-		probabilitySliderεη = p[192];
-		probabilitySliderζα = p[193];
-		probabilitySliderζβ = p[194];
-		probabilitySliderζγ = p[195];
-		probabilitySliderζδ = p[196];
-		probabilitySliderζε = p[197];
-		probabilitySliderζζ = p[198];
-		probabilitySliderζη = p[199];
-		probabilitySliderηα = p[200];
-		probabilitySliderηβ = p[201];
-		probabilitySliderηγ = p[202];
-		probabilitySliderηδ = p[203];
-		probabilitySliderηε = p[204];
-		probabilitySliderηζ = p[205];
-		probabilitySliderηη = p[206];
-		minPowerSlider = p[207];
-		maxPowerSlider = p[208];
-		minRangeSlider = p[209];
-		maxRangeSlider = p[210];
-		ProbabilityEvoProbSlider = p[211];
-		ProbabilityEvoAmountSlider = p[212];
-		ViscosityEvoProbSlider = p[213];
-		ViscosityEvoAmountSlider = p[214];
-		viscositySliderαθ = p[215];
-		viscositySliderβθ = p[216];
-		viscositySliderγθ = p[217];
-		viscositySliderδθ = p[218];
-		viscositySliderεθ = p[219];
-		viscositySliderζθ = p[220];
-		viscositySliderηθ = p[221];
-		viscositySliderθα = p[222];
-		viscositySliderθβ = p[223];
-		viscositySliderθγ = p[224];
-		viscositySliderθδ = p[225];
-		viscositySliderθε = p[226];
-		viscositySliderθζ = p[227];
-		viscositySliderθη = p[228];
-		viscositySliderθθ = p[229];
-		probabilitySliderαθ = p[230];
-		probabilitySliderβθ = p[231];
-		probabilitySliderγθ = p[232];
-		probabilitySliderδθ = p[233];
-		probabilitySliderεθ = p[234];
-		probabilitySliderζθ = p[235];
-		probabilitySliderηθ = p[236];
-		probabilitySliderθα = p[237];
-		probabilitySliderθβ = p[238];
-		probabilitySliderθγ = p[239];
-		probabilitySliderθδ = p[240];
-		probabilitySliderθε = p[241];
-		probabilitySliderθζ = p[242];
-		probabilitySliderθη = p[243];
-		probabilitySliderθθ = p[244];
-		numberSliderθ = static_cast<int>(p[245]);
-		powerSliderαθ = p[246];
-		powerSliderβθ = p[247];
-		powerSliderδθ = p[248];
-		powerSliderγθ = p[249];
-		powerSliderεθ = p[250];
-		powerSliderζθ = p[251];
-		powerSliderηθ = p[252];
-		powerSliderθα = p[253];
-		powerSliderθβ = p[254];
-		powerSliderθδ = p[255];
-		powerSliderθγ = p[256];
-		powerSliderθε = p[257];
-		powerSliderθζ = p[258];
-		powerSliderθη = p[259];
-		powerSliderθθ = p[260];
-		vSliderαθ = p[261];
-		vSliderβθ = p[262];
-		vSliderδθ = p[263];
-		vSliderγθ = p[264];
-		vSliderεθ = p[265];
-		vSliderζθ = p[266];
-		vSliderηθ = p[267];
-		vSliderθα = p[268];
-		vSliderθβ = p[269];
-		vSliderθδ = p[270];
-		vSliderθγ = p[271];
-		vSliderθε = p[272];
-		vSliderθζ = p[273];
-		vSliderθη = p[274];
-		vSliderθθ = p[275];
-		minViscoSlider = p[276];
-		maxViscoSlider = p[277];
-		minProbSlider = p[278];
-		maxProbSlider = p[279];
+		applyModel(model);
 	}
 	restart();
 }
@@ -2060,9 +303,17 @@ void ofApp::setup()
 	gui.loadFont("Arial", 12);
 	gui.setWidthElements(300.0f);
 	gui.add(fps.setup("FPS", "0"));
+	gui.add(stepsLabel.setup("steps/s", "0"));
 	gui.add(physicLabel.setup("physic (ms)", "0"));
+	gui.add(kernelLabel.setup("kernel", simdLevelName(detectSimdLevel())));
+	gui.add(treeErrorLabel.setup("tree error (%)", "-"));
+	gui.add(verletLabel.setup("list builds", "-"));
 	gui.add(resetButton.setup("Restart (r)"));
 	gui.add(motionBlurToggle.setup("Motion Blur", false));
+	gui.add(trailSlider.setup("Trail length (frames)", trailLength, 1, 120));
+	gui.add(heatmapToggle.setup("Density heatmap", false));
+	gui.add(heatmapExposureSlider.setup("Heatmap exposure", heatmapExposure, 0.1, 4));
+	gui.add(heatmapSaveButton.setup("Save heatmap"));
 	gui.add(save.setup("Save Model"));
 	gui.add(load.setup("Load Model"));
 	//gui.add(modelToggle.setup("Show Model", false));
@@ -2079,14 +330,14 @@ void ofApp::setup()
 
 	// Quantity Group
 	qtyGroup.setup("Quantity (require restart/randomize)");
-	qtyGroup.add(numberSliderα.setup("Alpha", pnumberSliderα, 0, 10000));
-	qtyGroup.add(numberSliderβ.setup("betha", pnumberSliderβ, 0, 10000));
-	qtyGroup.add(numberSliderγ.setup("Gamma", pnumberSliderγ, 0, 10000));
-	qtyGroup.add(numberSliderδ.setup("Delta", pnumberSliderδ, 0, 10000));
-	qtyGroup.add(numberSliderε.setup("Epsilon", pnumberSliderε, 0, 10000));
-	qtyGroup.add(numberSliderζ.setup("Zeta", pnumberSliderζ, 0, 10000));
-	qtyGroup.add(numberSliderη.setup("Eta", pnumberSliderη, 0, 10000));
-	qtyGroup.add(numberSliderθ.setup("Teta", pnumberSliderθ, 0, 10000));
+	qtyGroup.add(numberSliderα.setup("Alpha", pnumberSliderα, 0, COUNT_SLIDER_MAX));
+	qtyGroup.add(numberSliderβ.setup("betha", pnumberSliderβ, 0, COUNT_SLIDER_MAX));
+	qtyGroup.add(numberSliderγ.setup("Gamma", pnumberSliderγ, 0, COUNT_SLIDER_MAX));
+	qtyGroup.add(numberSliderδ.setup("Delta", pnumberSliderδ, 0, COUNT_SLIDER_MAX));
+	qtyGroup.add(numberSliderε.setup("Epsilon", pnumberSliderε, 0, COUNT_SLIDER_MAX));
+	qtyGroup.add(numberSliderζ.setup("Zeta", pnumberSliderζ, 0, COUNT_SLIDER_MAX));
+	qtyGroup.add(numberSliderη.setup("Eta", pnumberSliderη, 0, COUNT_SLIDER_MAX));
+	qtyGroup.add(numberSliderθ.setup("Teta", pnumberSliderθ, 0, COUNT_SLIDER_MAX));
 	gui.add(&qtyGroup);
 	qtyGroup.minimize();
 
@@ -2416,22 +667,45 @@ void ofApp::setup()
 	expGroup.setup("Experimental");
 	expGroup.add(freezeButton.setup("Freeze (f)"));
 	expGroup.add(boundsToggle.setup("Bounded", true));
+	expGroup.add(periodicToggle.setup("Periodic forces", false));
 	expGroup.add(radiusToogle.setup("infinite radius", false));
+	expGroup.add(openingAngleSlider.setup("Opening angle", openingAngle, 0, 1.5));
+	expGroup.add(verletToggle.setup("Verlet lists", false));
+	expGroup.add(verletSkinSlider.setup("Verlet skin (0 = auto)", verletSkin, 0, 20));
 	expGroup.add(wallRepelSlider.setup("Wall Repel", wallRepel, 0, 100));
 	expGroup.add(gravitySlider.setup("Gravity", worldGravity, -1, 1));
+	expGroup.add(falloffSlider.setup("Force falloff", forceFalloff, 0, 4));
+	expGroup.add(coreSlider.setup("Repulsive core", forceCore, 0, 1));
+	expGroup.add(massGravitySlider.setup("Mass gravity", massGravity, -1, 1));
+	expGroup.add(physicsRateSlider.setup("Physics rate (0 = max)", physicsRate, 0, 240));
 	expGroup.minimize();
 	gui.add(&expGroup);
 
 	ofSetBackgroundAuto(false);
 	ofEnableAlphaBlending();
+	renderer.setup();
+	trails.setup();
+	auto region = 0;
+	for (auto& snapshot : snapshots) snapshot.region = region++;
 
 	restart();
+
+	simulating = true;
+	simulationThread = std::thread(&ofApp::simulate, this);
+}
+
+//--------------------------------------------------------------
+void ofApp::exit()
+{
+	simulating = false;
+	if (simulationThread.joinable()) simulationThread.join();
+	renderer.release();
+	trails.release();
 }
 
 //------------------------------Update simulation with sliders values------------------------------
 void ofApp::update()
 {
-	physic_begin = clock();
 	minP = minPowerSlider;
 	maxP = maxPowerSlider;
 	minR = minRangeSlider;
@@ -2571,6 +845,11 @@ void ofApp::update()
 	viscosityθθ = viscositySliderθθ;
 	worldGravity = gravitySlider;
 	wallRepel = wallRepelSlider;
+	openingAngle = openingAngleSlider;
+	verletSkin = verletSkinSlider;
+	forceFalloff = falloffSlider;
+	forceCore = coreSlider;
+	massGravity = massGravitySlider;
 	InterEvoChance = InteractionEvoProbSlider;
 	InterEvoAmount = InteractionEvoAmountSlider;
 	ProbEvoChance = ProbabilityEvoProbSlider;
@@ -2608,119 +887,97 @@ void ofApp::update()
 		}
 	}
 
-	if (numberSliderα > 0)
+	for (auto k = 0; k < TYPE_COUNT * TYPE_COUNT; k++)
 	{
-		interaction(&alpha, &alpha, powerSliderαα, vSliderαα, viscosityαα, probabilityαα);
-		if (numberSliderβ > 0) interaction(&alpha, &betha, powerSliderαβ, vSliderαβ, viscosityαβ, probabilityαβ);
-		if (numberSliderγ > 0) interaction(&alpha, &gamma, powerSliderαγ, vSliderαγ, viscosityαγ, probabilityαγ);
-		if (numberSliderδ > 0) interaction(&alpha, &elta, powerSliderαδ, vSliderαδ, viscosityαδ, probabilityαδ);
-		if (numberSliderε > 0) interaction(&alpha, &epsilon, powerSliderαε, vSliderαε, viscosityαε, probabilityαε);
-		if (numberSliderζ > 0) interaction(&alpha, &zeta, powerSliderαζ, vSliderαζ, viscosityαζ, probabilityαζ);
-		if (numberSliderη > 0) interaction(&alpha, &eta, powerSliderαη, vSliderαη, viscosityαη, probabilityαη);
-		if (numberSliderθ > 0) interaction(&alpha, &teta, powerSliderαθ, vSliderαθ, viscosityαθ, probabilityαθ);
+		params.matrix.power[k / TYPE_COUNT][k % TYPE_COUNT] = *powersliders[k];
+		params.matrix.radius[k / TYPE_COUNT][k % TYPE_COUNT] = *vsliders[k];
+		params.matrix.viscosity[k / TYPE_COUNT][k % TYPE_COUNT] = *viscositysliders[k];
+		params.matrix.probability[k / TYPE_COUNT][k % TYPE_COUNT] = *probabilitysliders[k];
 	}
+	for (auto t = 0; t < TYPE_COUNT; t++) params.active[t] = *numbersliders[t] > 0;
+	std::fill(params.matrix.falloff.values.begin(), params.matrix.falloff.values.end(), forceFalloff);
+	std::fill(params.matrix.core.values.begin(), params.matrix.core.values.end(), forceCore);
 
-	if (numberSliderβ > 0)
+	boundWidth = ofGetWidth();
+	boundHeight = ofGetHeight();
+	params.width = ofGetWidth();
+	params.height = ofGetHeight();
+	params.infinite = radiusToogle;
+	params.bounded = boundsToggle;
+	params.periodic = periodicToggle;
+	params.verlet = verletToggle;
+	params.skin = verletSkin;
+	params.openingAngle = openingAngle;
+	params.gravity = worldGravity;
+	params.wallRepel = wallRepel;
+	params.massGravity = massGravity;
+	physicsRate = physicsRateSlider;
+	trailLength = trailSlider;
+	heatmapExposure = heatmapExposureSlider;
+
+	// the simulation thread picks them up before its next step
 	{
-		interaction(&betha, &betha, powerSliderββ, vSliderββ, viscosityββ, probabilityββ);
-		if (numberSliderα > 0) interaction(&betha, &alpha, powerSliderβα, vSliderβα, viscosityβα, probabilityβα);
-		if (numberSliderγ > 0) interaction(&betha, &gamma, powerSliderβγ, vSliderβγ, viscosityβγ, probabilityβγ);
-		if (numberSliderδ > 0) interaction(&betha, &elta, powerSliderβδ, vSliderβδ, viscosityβδ, probabilityβδ);
-		if (numberSliderε > 0) interaction(&betha, &epsilon, powerSliderβε, vSliderβε, viscosityβε, probabilityβε);
-		if (numberSliderζ > 0) interaction(&betha, &zeta, powerSliderβζ, vSliderβζ, viscosityβζ, probabilityβζ);
-		if (numberSliderη > 0) interaction(&betha, &eta, powerSliderβη, vSliderβη, viscosityβη, probabilityβη);
-		if (numberSliderθ > 0) interaction(&betha, &teta, powerSliderβθ, vSliderβθ, viscosityβθ, probabilityβθ);
+		std::lock_guard<std::mutex> lock(paramsMutex);
+		pendingParams = params;
+		pendingRate = physicsRate;
+		pendingHeatmap = heatmapToggle;
+		paramsReady = true;
 	}
 
-	if (numberSliderγ > 0)
-	{
-		interaction(&gamma, &gamma, powerSliderγγ, vSliderγγ, viscosityγγ, probabilityγγ);
-		if (numberSliderα > 0) interaction(&gamma, &alpha, powerSliderγα, vSliderγα, viscosityγα, probabilityγα);
-		if (numberSliderβ > 0) interaction(&gamma, &betha, powerSliderγβ, vSliderγβ, viscosityγβ, probabilityγβ);
-		if (numberSliderδ > 0) interaction(&gamma, &elta, powerSliderγδ, vSliderγδ, viscosityγδ, probabilityγδ);
-		if (numberSliderε > 0) interaction(&gamma, &epsilon, powerSliderγε, vSliderγε, viscosityγε, probabilityγε);
-		if (numberSliderζ > 0) interaction(&gamma, &zeta, powerSliderγζ, vSliderγζ, viscosityγζ, probabilityγζ);
-		if (numberSliderη > 0) interaction(&gamma, &eta, powerSliderγη, vSliderγη, viscosityγη, probabilityγη);
-		if (numberSliderθ > 0) interaction(&gamma, &teta, powerSliderγθ, vSliderγθ, viscosityγθ, probabilityγθ);
-	}
+	if (save) { saveSettings(); }
+	if (load) { loadSettings(); }
+}
 
-	if (numberSliderδ > 0)
-	{
-		interaction(&elta, &elta, powerSliderδδ, vSliderδδ, viscosityδδ, probabilityδδ);
-		if (numberSliderα > 0) interaction(&elta, &alpha, powerSliderδα, vSliderδα, viscosityδα, probabilityδα);
-		if (numberSliderβ > 0) interaction(&elta, &betha, powerSliderδβ, vSliderδβ, viscosityδβ, probabilityδβ);
-		if (numberSliderγ > 0) interaction(&elta, &gamma, powerSliderδγ, vSliderδγ, viscosityδγ, probabilityδγ);
-		if (numberSliderε > 0) interaction(&elta, &epsilon, powerSliderδε, vSliderδε, viscosityδε, probabilityδε);
-		if (numberSliderζ > 0) interaction(&elta, &zeta, powerSliderδζ, vSliderδζ, viscosityδζ, probabilityδζ);
-		if (numberSliderη > 0) interaction(&elta, &eta, powerSliderδη, vSliderδη, viscosityδη, probabilityδη);
-		if (numberSliderθ > 0) interaction(&elta, &teta, powerSliderδθ, vSliderδθ, viscosityδθ, probabilityδθ);
-	}
+//--------------------------------------------------------------
+void ofApp::drawParticles(const frameSnapshot& snapshot)
+{
+	if (!snapshot.streamed) renderer.upload(snapshot.particles, snapshot.frame);
 
-	if (numberSliderε > 0)
-	{
-		interaction(&epsilon, &epsilon, powerSliderεε, vSliderεε, viscosityεε, probabilityεε);
-		if (numberSliderα > 0) interaction(&epsilon, &alpha, powerSliderεα, vSliderεα, viscosityεα, probabilityεα);
-		if (numberSliderβ > 0) interaction(&epsilon, &betha, powerSliderεβ, vSliderεβ, viscosityεβ, probabilityεβ);
-		if (numberSliderγ > 0) interaction(&epsilon, &gamma, powerSliderεγ, vSliderεγ, viscosityεγ, probabilityεγ);
-		if (numberSliderδ > 0) interaction(&epsilon, &elta, powerSliderεδ, vSliderεδ, viscosityεδ, probabilityεδ);
-		if (numberSliderζ > 0) interaction(&epsilon, &zeta, powerSliderεζ, vSliderεζ, viscosityεζ, probabilityεζ);
-		if (numberSliderη > 0) interaction(&epsilon, &eta, powerSliderεη, vSliderεη, viscosityεη, probabilityεη);
-		if (numberSliderθ > 0) interaction(&epsilon, &teta, powerSliderεθ, vSliderεθ, viscosityεθ, probabilityεθ);
-	}
+	// the particles go to the accumulation, over the faded trails of the previous frames, and the window only
+	// receives its composition under the interface; without it they are drawn straight to the cleared window
+	if (trails.ready()) trails.begin(ofGetWidth(), ofGetHeight(), motionBlurToggle ? trailBuffer::decay(trailLength) : 0.0F);
+	else ofClear(0);
 
-	if (numberSliderζ > 0)
+	// positions streamed before the stream was mapped again are lost, that frame shows no particles
+	const bool lost = snapshot.streamed && snapshot.generation != renderer.streamGeneration();
+	for (const int t : { 0, 1, 3, 2, 4, 5, 6, 7 })
 	{
-		interaction(&zeta, &zeta, powerSliderζζ, vSliderζζ, viscosityζζ, probabilityζζ);
-		if (numberSliderα > 0) interaction(&zeta, &alpha, powerSliderζα, vSliderζα, viscosityζα, probabilityζα);
-		if (numberSliderβ > 0) interaction(&zeta, &betha, powerSliderζβ, vSliderζβ, viscosityζβ, probabilityζβ);
-		if (numberSliderγ > 0) interaction(&zeta, &gamma, powerSliderζγ, vSliderζγ, viscosityζγ, probabilityζγ);
-		if (numberSliderδ > 0) interaction(&zeta, &elta, powerSliderζδ, vSliderζδ, viscosityζδ, probabilityζδ);
-		if (numberSliderε > 0) interaction(&zeta, &epsilon, powerSliderζε, vSliderζε, viscosityζε, probabilityζε);
-		if (numberSliderη > 0) interaction(&zeta, &eta, powerSliderζη, vSliderζη, viscosityζη, probabilityζη);
-		if (numberSliderθ > 0) interaction(&zeta, &teta, powerSliderζθ, vSliderζθ, viscosityζθ, probabilityζθ);
+		if (lost || t >= static_cast<int>(snapshot.active.size()) || !snapshot.active[t]) continue;
+		if (renderer.ready()) renderer.draw(snapshot.particles, t, 2.25F, 100, ofGetWidth(), ofGetHeight(), snapshot.streamed ? snapshot.region : -1);
+		else Draw(snapshot.particles, t);
 	}
-
-	if (numberSliderη > 0)
+	if (snapshot.streamed && !lost) renderer.fence(snapshot.region);
+	if (trails.ready())
 	{
-		interaction(&eta, &eta, powerSliderηη, vSliderηη, viscosityηη, probabilityηη);
-		if (numberSliderα > 0) interaction(&eta, &alpha, powerSliderηα, vSliderηα, viscosityηα, probabilityηα);
-		if (numberSliderβ > 0) interaction(&eta, &betha, powerSliderηβ, vSliderηβ, viscosityηβ, probabilityηβ);
-		if (numberSliderγ > 0) interaction(&eta, &gamma, powerSliderηγ, vSliderηγ, viscosityηγ, probabilityηγ);
-		if (numberSliderδ > 0) interaction(&eta, &elta, powerSliderηδ, vSliderηδ, viscosityηδ, probabilityηδ);
-		if (numberSliderε > 0) interaction(&eta, &epsilon, powerSliderηε, vSliderηε, viscosityηε, probabilityηε);
-		if (numberSliderζ > 0) interaction(&eta, &zeta, powerSliderηζ, vSliderηζ, viscosityηζ, probabilityηζ);
-		if (numberSliderθ > 0) interaction(&eta, &teta, powerSliderηθ, vSliderηθ, viscosityηθ, probabilityηθ);
+		trails.end();
+		trails.compose();
 	}
+}
 
-	if (numberSliderθ > 0)
+/**
+ * @brief Draw the density of the particles in their place, and save it on demand
+ *
+ * The positions are the ones the simulation thread copied into the snapshot, the stream is never read back.
+ */
+void ofApp::drawHeatmap(const frameSnapshot& snapshot)
+{
+	heatmap.exposure = heatmapExposure;
+	heatmap.render(snapshot.particles, snapshot.active, ofGetWidth(), ofGetHeight(), ofGetWidth(), ofGetHeight());
+	heatmapTexture.loadData(heatmap.image().data(), heatmap.width(), heatmap.height(), GL_RGBA);
+	ofSetColor(255);
+	heatmapTexture.draw(0, 0);
+
+	if (heatmapSaveButton)
 	{
-		interaction(&teta, &teta, powerSliderθθ, vSliderθθ, viscosityθθ, probabilityθθ);
-		if (numberSliderα > 0) interaction(&teta, &alpha, powerSliderθα, vSliderθα, viscosityθα, probabilityθα);
-		if (numberSliderβ > 0) interaction(&teta, &betha, powerSliderθβ, vSliderθβ, viscosityθβ, probabilityθβ);
-		if (numberSliderγ > 0) interaction(&teta, &gamma, powerSliderθγ, vSliderθγ, viscosityθγ, probabilityθγ);
-		if (numberSliderδ > 0) interaction(&teta, &elta, powerSliderθδ, vSliderθδ, viscosityθδ, probabilityθδ);
-		if (numberSliderε > 0) interaction(&teta, &epsilon, powerSliderθε, vSliderθε, viscosityθε, probabilityθε);
-		if (numberSliderζ > 0) interaction(&teta, &zeta, powerSliderθζ, vSliderθζ, viscosityθζ, probabilityθζ);
-		if (numberSliderη > 0) interaction(&teta, &eta, powerSliderθη, vSliderθη, viscosityθη, probabilityθη);
+		ofPixels pixels;
+		pixels.setFromPixels(heatmap.image().data(), heatmap.width(), heatmap.height(), OF_PIXELS_RGBA);
+		ofSaveImage(pixels, "heatmap_" + ofGetTimestampString() + ".png");
 	}
-
-	if (save) { saveSettings(); }
-	if (load) { loadSettings(); }
-	physic_delta = clock() - physic_begin;
 }
 
 //--------------------------------------------------------------
 void ofApp::draw()
 {
-	if (motionBlurToggle)
-	{
-		ofSetColor(0, 0, 0, 64);
-		ofDrawRectangle(0, 0, boundWidth, boundHeight);
-	}
-	else
-	{
-		ofClear(0);
-	}
 	//fps counter
 	cntFps++;
 	now = clock();
@@ -2731,7 +988,13 @@ void ofApp::draw()
 	{
 		lastTime = now;
 		fps.setup("FPS", to_string(static_cast<int>((1000 / static_cast<float>(delta)) * cntFps)));
-		physicLabel.setup("physics (ms)", to_string(physic_delta));
+		const frameSnapshot& snapshot = snapshots.front();
+		stepsLabel.setup("steps/s", to_string(static_cast<int>((1000 / static_cast<float>(delta)) * (snapshot.frame >= lastFrame ? snapshot.frame - lastFrame : snapshot.frame))));
+		physicLabel.setup("physics (ms)", ofToString(snapshot.stepMs, 2));
+		treeErrorLabel.setup("tree error (%)", radiusToogle ? ofToString(snapshot.treeError, 3) : "-");
+		verletLabel.setup("list builds", verletToggle ? to_string(snapshot.listBuilds - lastBuilds) : "-");
+		lastBuilds = snapshot.listBuilds;
+		lastFrame = snapshot.frame;
 
 		cntFps = 0;
 	}
@@ -2771,14 +1034,21 @@ void ofApp::draw()
 	{
 		rndir();
 	}
-	if (numberSliderα > 0) { Draw(&alpha); }
-	if (numberSliderβ > 0) { Draw(&betha); }
-	if (numberSliderδ > 0) { Draw(&elta); }
-	if (numberSliderγ > 0) { Draw(&gamma); }
-	if (numberSliderε > 0) { Draw(&epsilon); }
-	if (numberSliderζ > 0) { Draw(&zeta); }
-	if (numberSliderη > 0) { Draw(&eta); }
-	if (numberSliderθ > 0) { Draw(&teta); }
+
+	// latest positions published by the simulation thread, in the former drawing order; the buffer drawn
+	// until now only goes back to the simulation thread once the GPU is done with its region of the stream
+	if (renderer.idle(snapshots.front().region)) snapshots.update();
+	const frameSnapshot& snapshot = snapshots.front();
+	if (heatmapToggle && !snapshot.streamed) drawHeatmap(snapshot);
+	else drawParticles(snapshot);
+
+	// the stream grows with the particles, the simulation thread must not write to it meanwhile; a context
+	// without the stream never takes the lock here, it would wait for a whole step for nothing
+	if (renderer.canStream() && !snapshot.streamed && snapshot.particles.size() > renderer.streamCapacity())
+	{
+		std::lock_guard<std::mutex> lock(groupsMutex);
+		renderer.reserve(snapshot.particles.size() + snapshot.particles.size() / 2);
+	}
 	if (numberSliderα < 0.0F) numberSliderα = 0;
 	if (numberSliderβ < 0.0F) numberSliderβ = 0;
 	if (numberSliderδ < 0.0F) numberSliderδ = 0;
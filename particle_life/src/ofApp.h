@@ -2,43 +2,40 @@
 
 #include "ofMain.h"
 #include "ofxGui.h"
-
-#define GRID_DIV 4
+#include "simulation.h"
+#include "model.h"
+#include "densityMap.h"
+#include "pointRenderer.h"
+#include "trailBuffer.h"
+#include "tripleBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// largest count of a group on the sliders: the density heatmap is meant for hundreds of thousands of particles
+#define COUNT_SLIDER_MAX 250000
+
+// threads of the density heatmap, a quarter of the cores; the step keeps the others, so both pools can spin
+// at once in heatmap mode without running more busy threads than there are cores
+inline int heatmapThreads() { return std::max(static_cast<int>(std::thread::hardware_concurrency()) / 4, 1); }
+inline int stepThreads() { return std::max(static_cast<int>(std::thread::hardware_concurrency()) - heatmapThreads(), 1); }
 
 /*
- * for collision detection :
- * if (distance(x center, x line) < radius) then intersect 
+ * Positions published by the simulation thread for draw(), with the statistics of the step.
  */
-
-struct point
+struct frameSnapshot
 {
-	point(float _x, float _y, const int _r, const int _g, const int _b) : x(_x), y(_y), r(_r), g(_g), b(_b) {}
-
-	//Position
-	float x;
-	float y;
-
-	//Velocity
-	float vx = 0;
-	float vy = 0;
-
-	//Color
-	const int r;
-	const int g;
-	const int b;
-	
-	int gridId = -1;
-
-	void draw() const
-	{
-		ofSetColor(r, g, b, 100); //set particle color + some alpha
-		ofDrawCircle(x, y, 2.25F); //draw a point at x,y coordinates, the size of a 2.25 pixels
-	}
-};
-
-struct grid
-{
-	const int gridSize = GRID_DIV * GRID_DIV; // must be a power of 2
+	particleBuffer particles;	// positions, groups and colors only
+	std::vector<bool> active;
+	int region = 0;				// region of the stream of the renderer that belongs to this buffer
+	bool streamed = false;		// the positions were written to the region, particles.x and y are not used
+	uint32_t generation = 0;	// generation of the stream they were written to
+	uint32_t frame = 0;
+	float stepMs = 0.0F;
+	float treeError = 0.0F;
+	int listBuilds = 0;
 };
 
 //---------------------------------------------CONFIGURE GUI---------------------------------------------//
@@ -48,6 +45,7 @@ public:
 	void setup() override;
 	void update() override;
 	void draw() override;
+	void exit() override;
 	void keyPressed(int key) override;
 	void restart();
 	void random();
@@ -59,7 +57,11 @@ public:
 	void freeze();
 	void saveSettings();
 	void loadSettings();
-	void interaction(std::vector<point>* Group1, const std::vector<point>* Group2, float G, float radius, float viscosity, float probability);
+	simulationModel currentModel();
+	void applyModel(const simulationModel& model);
+	void simulate();
+	void drawParticles(const frameSnapshot& snapshot);
+	void drawHeatmap(const frameSnapshot& snapshot);
 
 	ofxPanel gui;
 
@@ -91,8 +93,13 @@ public:
 	ofxButton randomVsc;
 
 	ofxToggle boundsToggle;
+	ofxToggle periodicToggle;
 	ofxToggle modelToggle;
 	ofxToggle motionBlurToggle;
+	ofxFloatSlider trailSlider;
+	ofxToggle heatmapToggle;
+	ofxFloatSlider heatmapExposureSlider;
+	ofxButton heatmapSaveButton;
 
 	// some experimental stuff here
 	ofxGuiGroup expGroup;
@@ -126,7 +133,13 @@ public:
 	float minI = 0.0;
 	float maxI = 100.0;
 	ofxToggle radiusToogle;
+	ofxFloatSlider openingAngleSlider;
+	ofxToggle verletToggle;
+	ofxFloatSlider verletSkinSlider;
 	ofxLabel physicLabel;
+	ofxLabel kernelLabel;
+	ofxLabel treeErrorLabel;
+	ofxLabel verletLabel;
 	//end of experimental
 
 	ofxFloatSlider viscositySlider;
@@ -353,6 +366,9 @@ public:
 
 	ofxFloatSlider gravitySlider;
 	ofxFloatSlider wallRepelSlider;
+	ofxFloatSlider falloffSlider;
+	ofxFloatSlider coreSlider;
+	ofxFloatSlider massGravitySlider;
 
 	ofxIntSlider numberSliderα;
 	ofxIntSlider numberSliderβ;
@@ -672,6 +688,38 @@ public:
 	ofxLabel aboutL2;
 	ofxLabel aboutL3;
 	ofxLabel fps;
+	ofxLabel stepsLabel;
+	ofxFloatSlider physicsRateSlider;
+
+	// parameters of the next steps, written by update()
+	simulationParams params;
+
+	// the engine, stepped by the simulation thread, restart() gives it a new seed
+	simulation world{ stepThreads() };
+
+	// random numbers of the randomizer buttons
+	std::mt19937 rng{ std::random_device{}() };
+
+	// simulation thread: it steps at a fixed rate (or as fast as it can with a rate of 0) and publishes
+	// its positions through the triple buffer, so neither draw() nor the step ever waits for the other
+	std::thread simulationThread;
+	std::atomic<bool> simulating{ false };
+	std::mutex paramsMutex;			// guards pendingParams, paramsReady, pendingRate and pendingHeatmap
+	simulationParams pendingParams;
+	bool paramsReady = false;
+	float pendingRate = 60.0F;
+	bool pendingHeatmap = false;	// the snapshots keep their positions for the heatmap instead of streaming them
+	std::mutex groupsMutex;			// held by a step, and by restart() while it replaces the groups
+	tripleBuffer<frameSnapshot> snapshots;
+	pointRenderer renderer;			// draws the snapshots, Draw() when the context has no shaders; its stream is
+									// written by the simulation thread, and mapped again by draw() while it holds groupsMutex
+	trailBuffer trails;				// accumulation of the particle pass, composed under the interface
+	float trailLength = 14.0F;		// frames of the trails of the motion blur
+	densityMap heatmap{ heatmapThreads() };	// density of the particles in place of the particles, on its own threads
+	ofTexture heatmapTexture;
+	float heatmapExposure = 1.0F;
+	uint32_t lastFrame = 0;			// snapshot frame at the last refresh of the labels
+	float physicsRate = 60.0F;		// steps per second, 0 for as fast as possible
 
 	// simulation bounds
 	int boundWidth = 1600;
@@ -755,6 +803,12 @@ public:
 	float forceVariance = 0.7F;
 	float radiusVariance = 0.5F;
 	float wallRepel = 20.0F;
+	float openingAngle = 0.5F;	// Barnes-Hut opening angle of the infinite radius mode
+	float forceFalloff = 0.0F;	// force profile of every pair, a constant force with both at 0
+	float forceCore = 0.0F;
+	float massGravity = 0.0F;	// gravity of the masses of the particles, through the particle mesh
+	float verletSkin = 0.0F;	// margin added to the radii by the Verlet lists, 0 for one that follows the speed
+	int lastBuilds = 0;			// Verlet list builds at the last refresh of the labels
 
 	vector<ofxFloatSlider*> powersliders = {
 		&powerSliderαα, &powerSliderαβ, &powerSliderαγ, &powerSliderαδ,	&powerSliderαε, &powerSliderαζ, &powerSliderαη, &powerSliderαθ,
@@ -796,4 +850,7 @@ public:
 		&probabilitySliderηα, &probabilitySliderηβ, &probabilitySliderηγ, &probabilitySliderηδ, &probabilitySliderηε, &probabilitySliderηζ, &probabilitySliderηη, &probabilitySliderηθ,
 		&probabilitySliderθα, &probabilitySliderθβ, &probabilitySliderθγ, &probabilitySliderθδ, &probabilitySliderθε, &probabilitySliderθζ, &probabilitySliderθη, &probabilitySliderθθ,
 	};
+	vector<ofxIntSlider*> numbersliders = {
+		&numberSliderα, &numberSliderβ, &numberSliderγ, &numberSliderδ, &numberSliderε, &numberSliderζ, &numberSliderη, &numberSliderθ,
+	};
 };
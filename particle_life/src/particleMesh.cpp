@@ -0,0 +1,318 @@
+#include "particleMesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const double pi = 3.14159265358979323846;
+
+/**
+ * @brief In place radix 2 transforms of MESH_BLOCK interleaved sequences of a power of 2 length
+ *
+ * The sequences are transformed side by side, so that their butterflies run together in vector registers.
+ *
+ * @param re real parts, value j of sequence l at j * MESH_BLOCK + l, replaced by the transforms
+ * @param im imaginary parts
+ * @param n number of values of each sequence
+ * @param twiddles exp(-2 i pi k / n) for k below n / 2, or their conjugates for the inverse transforms,
+ * which are then not divided by n
+ */
+static void fft(float* re, float* im, const int n, const std::complex<float>* twiddles)
+{
+	// bit reversed order
+	for (int i = 1, j = 0; i < n; i++)
+	{
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j)
+		{
+			std::swap_ranges(re + i * MESH_BLOCK, re + (i + 1) * MESH_BLOCK, re + j * MESH_BLOCK);
+			std::swap_ranges(im + i * MESH_BLOCK, im + (i + 1) * MESH_BLOCK, im + j * MESH_BLOCK);
+		}
+	}
+
+	// butterflies of growing length
+	for (auto length = 2; length <= n; length <<= 1)
+	{
+		const int half = length / 2;
+		const int step = n / length;
+		for (auto i = 0; i < n; i += length)
+		{
+			for (auto k = 0; k < half; k++)
+			{
+				const float wr = twiddles[k * step].real();
+				const float wi = twiddles[k * step].imag();
+				float* ur = re + (i + k) * MESH_BLOCK;
+				float* ui = im + (i + k) * MESH_BLOCK;
+				float* vr = re + (i + k + half) * MESH_BLOCK;
+				float* vi = im + (i + k + half) * MESH_BLOCK;
+#pragma omp simd
+				for (auto l = 0; l < MESH_BLOCK; l++)
+				{
+					const float xr = vr[l] * wr - vi[l] * wi;
+					const float xi = vr[l] * wi + vi[l] * wr;
+					vr[l] = ur[l] - xr;
+					vi[l] = ui[l] - xi;
+					ur[l] += xr;
+					ui[l] += xi;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Transform MESH_BLOCK rows of a square array in place
+ *
+ * @param data n * n values, row major
+ * @param n side of the array
+ * @param rows indices of the rows
+ * @param twiddles as for fft()
+ */
+static void fftRows(std::complex<float>* data, const int n, const int* rows, const std::complex<float>* twiddles)
+{
+	std::vector<float> re(static_cast<size_t>(n) * MESH_BLOCK);
+	std::vector<float> im(static_cast<size_t>(n) * MESH_BLOCK);
+	for (auto l = 0; l < MESH_BLOCK; l++)
+	{
+		const std::complex<float>* line = data + static_cast<size_t>(rows[l]) * n;
+		for (auto i = 0; i < n; i++)
+		{
+			re[i * MESH_BLOCK + l] = line[i].real();
+			im[i * MESH_BLOCK + l] = line[i].imag();
+		}
+	}
+	fft(re.data(), im.data(), n, twiddles);
+	for (auto l = 0; l < MESH_BLOCK; l++)
+	{
+		std::complex<float>* line = data + static_cast<size_t>(rows[l]) * n;
+		for (auto i = 0; i < n; i++) line[i] = { re[i * MESH_BLOCK + l], im[i * MESH_BLOCK + l] };
+	}
+}
+
+/**
+ * @brief Transform MESH_BLOCK consecutive columns of a square array in place
+ *
+ * @param data n * n values, row major
+ * @param n side of the array
+ * @param first index of the first column
+ * @param twiddles as for fft()
+ * @param spectrum when not null, the columns are multiplied by it after the transform, and transformed
+ * again with inverseTwiddles
+ * @param inverseTwiddles twiddles of the second transform
+ */
+static void fftColumns(std::complex<float>* data, const int n, const int first, const std::complex<float>* twiddles,
+	const std::complex<float>* spectrum = nullptr, const std::complex<float>* inverseTwiddles = nullptr)
+{
+	std::vector<float> re(static_cast<size_t>(n) * MESH_BLOCK);
+	std::vector<float> im(static_cast<size_t>(n) * MESH_BLOCK);
+	for (auto j = 0; j < n; j++)
+	{
+		const std::complex<float>* line = data + static_cast<size_t>(j) * n + first;
+		for (auto l = 0; l < MESH_BLOCK; l++)
+		{
+			re[j * MESH_BLOCK + l] = line[l].real();
+			im[j * MESH_BLOCK + l] = line[l].imag();
+		}
+	}
+	fft(re.data(), im.data(), n, twiddles);
+	if (spectrum)
+	{
+		for (auto j = 0; j < n; j++)
+		{
+			const std::complex<float>* kernel = spectrum + static_cast<size_t>(j) * n + first;
+			for (auto l = 0; l < MESH_BLOCK; l++)
+			{
+				const float a = re[j * MESH_BLOCK + l];
+				const float b = im[j * MESH_BLOCK + l];
+				re[j * MESH_BLOCK + l] = a * kernel[l].real() - b * kernel[l].imag();
+				im[j * MESH_BLOCK + l] = a * kernel[l].imag() + b * kernel[l].real();
+			}
+		}
+		fft(re.data(), im.data(), n, inverseTwiddles);
+	}
+	for (auto j = 0; j < n; j++)
+	{
+		std::complex<float>* line = data + static_cast<size_t>(j) * n + first;
+		for (auto l = 0; l < MESH_BLOCK; l++) line[l] = { re[j * MESH_BLOCK + l], im[j * MESH_BLOCK + l] };
+	}
+}
+
+float particleMesh::sample::stretch() const
+{
+	const float mean = (txx + tyy) / 2;
+	const float half = (txx - tyy) / 2;
+	return mean + std::sqrt(half * half + txy * txy);
+}
+
+void particleMesh::setup(const int cells, const int canvasWidth, const int canvasHeight, const bool wrap)
+{
+	if (cells == size && canvasWidth == width && canvasHeight == height && wrap == periodic) return;
+	size = cells;
+	width = canvasWidth;
+	height = canvasHeight;
+	periodic = wrap;
+	padded = periodic ? size : 2 * size;
+	cellWidth = static_cast<float>(width) / size;
+	cellHeight = static_cast<float>(height) / size;
+
+	copies.assign(static_cast<size_t>(MESH_COPIES) * size * size, 0.0F);
+	transform.assign(static_cast<size_t>(padded) * padded, 0.0F);
+	nodes.assign(static_cast<size_t>(size) * size, sample());
+	twiddles.resize(padded / 2);
+	inverseTwiddles.resize(padded / 2);
+	for (auto k = 0; k < padded / 2; k++)
+	{
+		twiddles[k] = std::polar(1.0F, static_cast<float>(-2.0 * pi * k / padded));
+		inverseTwiddles[k] = std::conj(twiddles[k]);
+	}
+
+	// potential of a unit mass at every offset of the mesh, the negative offsets wrapped to the end
+	const float softening = std::max(cellWidth, cellHeight);
+	spectrum.resize(static_cast<size_t>(padded) * padded);
+	for (auto j = 0; j < padded; j++)
+	{
+		const float dy = static_cast<float>(j <= padded / 2 ? j : j - padded) * cellHeight;
+		for (auto i = 0; i < padded; i++)
+		{
+			const float dx = static_cast<float>(i <= padded / 2 ? i : i - padded) * cellWidth;
+			spectrum[static_cast<size_t>(j) * padded + i] = -1.0F / std::sqrt(dx * dx + dy * dy + softening * softening);
+		}
+	}
+	for (auto first = 0; first < padded; first += MESH_BLOCK)
+	{
+		int rows[MESH_BLOCK];
+		for (auto l = 0; l < MESH_BLOCK; l++) rows[l] = first + l;
+		fftRows(spectrum.data(), padded, rows, twiddles.data());
+	}
+	for (auto first = 0; first < padded; first += MESH_BLOCK) fftColumns(spectrum.data(), padded, first, twiddles.data());
+}
+
+void particleMesh::clear(const int copy)
+{
+	std::fill_n(copies.begin() + static_cast<size_t>(copy) * size * size, static_cast<size_t>(size) * size, 0.0F);
+}
+
+void particleMesh::weights(const float x, const float y, int& i, int& j, float& wx, float& wy) const
+{
+	// the nodes are at the centers of the cells
+	float u = x / cellWidth - 0.5F;
+	float v = y / cellHeight - 0.5F;
+	if (periodic)
+	{
+		i = static_cast<int>(std::floor(u));
+		j = static_cast<int>(std::floor(v));
+	}
+	else
+	{
+		u = std::min(std::max(u, 0.0F), static_cast<float>(size - 1));
+		v = std::min(std::max(v, 0.0F), static_cast<float>(size - 1));
+		i = std::min(static_cast<int>(u), size - 2);
+		j = std::min(static_cast<int>(v), size - 2);
+	}
+	wx = u - static_cast<float>(i);
+	wy = v - static_cast<float>(j);
+}
+
+int particleMesh::node(int i, int j) const
+{
+	if (periodic)
+	{
+		i = (i % size + size) % size;
+		j = (j % size + size) % size;
+	}
+	return j * size + i;
+}
+
+void particleMesh::deposit(const int copy, const float x, const float y, const float mass)
+{
+	int i;
+	int j;
+	float wx;
+	float wy;
+	weights(x, y, i, j, wx, wy);
+	float* mesh = copies.data() + static_cast<size_t>(copy) * size * size;
+	mesh[node(i, j)] += mass * (1 - wx) * (1 - wy);
+	mesh[node(i + 1, j)] += mass * wx * (1 - wy);
+	mesh[node(i, j + 1)] += mass * (1 - wx) * wy;
+	mesh[node(i + 1, j + 1)] += mass * wx * wy;
+}
+
+void particleMesh::gather(const int row)
+{
+	std::complex<float>* line = transform.data() + static_cast<size_t>(row) * padded;
+	std::fill_n(line, padded, 0.0F);
+	if (row >= size) return;
+	for (auto copy = 0; copy < MESH_COPIES; copy++)
+	{
+		const float* mesh = copies.data() + (static_cast<size_t>(copy) * size + row) * size;
+		for (auto i = 0; i < size; i++) line[i] += mesh[i];
+	}
+}
+
+void particleMesh::forwardRows(const int block)
+{
+	int rows[MESH_BLOCK];
+	for (auto l = 0; l < MESH_BLOCK; l++) rows[l] = block * MESH_BLOCK + l;
+	fftRows(transform.data(), padded, rows, twiddles.data());
+}
+
+void particleMesh::convolveColumns(const int block)
+{
+	fftColumns(transform.data(), padded, block * MESH_BLOCK, twiddles.data(), spectrum.data(), inverseTwiddles.data());
+}
+
+void particleMesh::inverseRows(const int block)
+{
+	// the rows of the canvas, framed by the row before and the rows after on the padded mesh
+	int rows[MESH_BLOCK];
+	for (auto l = 0; l < MESH_BLOCK; l++) rows[l] = periodic ? block * MESH_BLOCK + l : (block * MESH_BLOCK + l + padded - 1) % padded;
+	fftRows(transform.data(), padded, rows, inverseTwiddles.data());
+}
+
+void particleMesh::differentiate(const int row, const float gravity)
+{
+	// the potential is read around the canvas: on the padded mesh the row and the column past each border
+	// are still exact, the offsets from the masses are at most the padded size
+	const float scale = gravity / (static_cast<float>(padded) * padded);
+	const auto potential = [&](const int i, const int j)
+	{
+		return transform[static_cast<size_t>((j + padded) % padded) * padded + (i + padded) % padded].real() * scale;
+	};
+	const int j = row;
+	for (auto i = 0; i < size; i++)
+	{
+		const float center = potential(i, j);
+		sample& s = nodes[static_cast<size_t>(j) * size + i];
+		s.gx = -(potential(i + 1, j) - potential(i - 1, j)) / (2 * cellWidth);
+		s.gy = -(potential(i, j + 1) - potential(i, j - 1)) / (2 * cellHeight);
+		s.txx = -(potential(i + 1, j) - 2 * center + potential(i - 1, j)) / (cellWidth * cellWidth);
+		s.tyy = -(potential(i, j + 1) - 2 * center + potential(i, j - 1)) / (cellHeight * cellHeight);
+		s.txy = -(potential(i + 1, j + 1) - potential(i + 1, j - 1) - potential(i - 1, j + 1) + potential(i - 1, j - 1)) / (4 * cellWidth * cellHeight);
+	}
+}
+
+particleMesh::sample particleMesh::interpolate(const float x, const float y) const
+{
+	int i;
+	int j;
+	float wx;
+	float wy;
+	weights(x, y, i, j, wx, wy);
+	const sample& a = nodes[node(i, j)];
+	const sample& b = nodes[node(i + 1, j)];
+	const sample& c = nodes[node(i, j + 1)];
+	const sample& d = nodes[node(i + 1, j + 1)];
+	const float wa = (1 - wx) * (1 - wy);
+	const float wb = wx * (1 - wy);
+	const float wc = (1 - wx) * wy;
+	const float wd = wx * wy;
+
+	sample s;
+	s.gx = wa * a.gx + wb * b.gx + wc * c.gx + wd * d.gx;
+	s.gy = wa * a.gy + wb * b.gy + wc * c.gy + wd * d.gy;
+	s.txx = wa * a.txx + wb * b.txx + wc * c.txx + wd * d.txx;
+	s.txy = wa * a.txy + wb * b.txy + wc * c.txy + wd * d.txy;
+	s.tyy = wa * a.tyy + wb * b.tyy + wc * c.tyy + wd * d.tyy;
+	return s;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+/*
+ * Particle mesh solver for the mass gravity.
+ * Every particle has the mass of its group, and pulls every other one with an intensity that decreases with
+ * the square of the distance, without any range. Instead of summing the N^2 pairs, the masses are deposited
+ * on a mesh over the canvas with cloud in cell weights, the potential of the mesh comes from a convolution
+ * done in Fourier space, and the field and its gradient (the tidal tensor) are interpolated back to the
+ * particles with the same weights, so a step costs O(N + M^2 log M) for a mesh of M cells per side.
+ * The kernel of the convolution is the potential of a point mass of the plane, -1 / sqrt(d^2 + e^2) with a
+ * softening e of one cell: the -1 / k^2 of a Poisson solve in 2D would give the logarithmic potential and a
+ * force in 1 / d. On a periodic canvas the kernel is wrapped around the mesh, each mass is seen through its
+ * nearest image; otherwise the mesh is padded to twice its size so that the masses do not see each other
+ * through the borders, and the particles outside of the canvas are clamped to its border cells.
+ * The work is split into tiles of rows, columns and particles, for the stages of the thread pool. The
+ * masses are deposited on MESH_COPIES private meshes that are summed afterwards in a fixed order, so the
+ * result does not depend on the threads.
+ */
+
+#define MESH_COPIES 16 // private meshes of the deposit
+#define MESH_MAX_SIZE 1024 // largest number of cells per side
+#define MESH_BLOCK 8 // rows or columns transformed together, the mesh has at least as many cells per side
+
+struct particleMesh
+{
+	// field of the mesh at a position: acceleration and its gradient
+	struct sample
+	{
+		float gx = 0;
+		float gy = 0;
+		float txx = 0;	// tidal tensor, d(gx)/dx, d(gx)/dy = d(gy)/dx and d(gy)/dy
+		float txy = 0;
+		float tyy = 0;
+
+		// largest eigenvalue of the tidal tensor, how fast the field stretches a body along its main axis
+		float stretch() const;
+	};
+
+	int size = 0;			// cells per side of the canvas
+	int padded = 0;			// cells per side of the transforms, size or 2 * size
+	float cellWidth = 1.0F;
+	float cellHeight = 1.0F;
+	bool periodic = false;
+
+	/**
+	 * @brief Fit the mesh to the canvas
+	 *
+	 * The spectrum of the kernel is only computed again when one of the arguments changes.
+	 *
+	 * @param cells cells per side, a power of 2
+	 * @param canvasWidth canvas width
+	 * @param canvasHeight canvas height
+	 * @param wrap the masses are seen across the borders
+	 */
+	void setup(int cells, int canvasWidth, int canvasHeight, bool wrap);
+
+	// clear the private mesh of a deposit tile
+	void clear(int copy);
+
+	// add a mass to the private mesh of a deposit tile
+	void deposit(int copy, float x, float y, float mass);
+
+	// sum one row of the private meshes into the transform
+	void gather(int row);
+
+	// forward transform of a block of MESH_BLOCK rows, only the size / MESH_BLOCK blocks of the canvas hold masses
+	void forwardRows(int block);
+
+	// forward transform of a block of MESH_BLOCK columns, product by the spectrum of the kernel and inverse
+	// transform, padded / MESH_BLOCK blocks
+	void convolveColumns(int block);
+
+	// inverse transform of a block of the rows read by differentiate(), inverseBlocks() of them
+	void inverseRows(int block);
+	int inverseBlocks() const { return (periodic ? size : size + MESH_BLOCK) / MESH_BLOCK; }
+
+	// acceleration and tidal tensor of the nodes of one row of the canvas, scaled by the gravity constant
+	void differentiate(int row, float gravity);
+
+	// field at a position, from the nodes around it
+	sample interpolate(float x, float y) const;
+
+private:
+	// cloud in cell weights: first node and share of the next one, along each axis
+	void weights(float x, float y, int& i, int& j, float& wx, float& wy) const;
+
+	// node of the canvas mesh, wrapped or clamped
+	int node(int i, int j) const;
+
+	std::vector<float> copies;						// MESH_COPIES private meshes of size * size masses
+	std::vector<std::complex<float>> transform;		// padded * padded, masses then potential, row major
+	std::vector<std::complex<float>> spectrum;		// transform of the kernel
+	std::vector<std::complex<float>> twiddles;		// roots of unity of the transforms, padded / 2
+	std::vector<std::complex<float>> inverseTwiddles;
+	std::vector<sample> nodes;						// field of the nodes of the canvas, size * size
+	int width = 0;									// canvas of the spectrum
+	int height = 0;
+};
@@ -0,0 +1,205 @@
+#include "pointRenderer.h"
+#include "shaderProgram.h"
+
+#if defined(_WIN32)
+#include <GL/glew.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+#include <algorithm>
+
+// pixel positions to clip space, y going down like the canvas, and the size of the sprite
+static const char* vertexSource = R"(#version 120
+attribute float x;
+attribute float y;
+uniform vec2 canvas;
+uniform float size;
+void main()
+{
+	gl_Position = vec4(x / canvas.x * 2.0 - 1.0, 1.0 - y / canvas.y * 2.0, 0.0, 1.0);
+	gl_PointSize = size;
+}
+)";
+
+// disc of the given radius in the sprite, with a one pixel soft edge
+static const char* fragmentSource = R"(#version 120
+uniform vec4 color;
+uniform float size;
+uniform float radius;
+void main()
+{
+	float d = length(gl_PointCoord - vec2(0.5)) * size;
+	float coverage = clamp(radius + 0.5 - d, 0.0, 1.0);
+	if (coverage <= 0.0) discard;
+	gl_FragColor = vec4(color.rgb, color.a * coverage);
+}
+)";
+
+/**
+ * @brief Whether the current context can map a buffer persistently
+ */
+static bool hasBufferStorage()
+{
+#if defined(_WIN32)
+	if (glBufferStorage == nullptr || glFenceSync == nullptr) return false;
+#endif
+	// before 4.4 the extension is needed, with the fences of 3.2
+	return hasOpenGL(4, 4) || (hasOpenGL(3, 2) && hasExtension("GL_ARB_buffer_storage"));
+}
+
+void pointRenderer::release()
+{
+	unmap();
+	if (program != 0) glDeleteProgram(program);
+	if (buffers[0] != 0) glDeleteBuffers(2, buffers);
+	program = 0;
+	buffers[0] = buffers[1] = 0;
+	capacity = 0;
+	uploaded = 0;
+	filled = false;
+}
+
+bool pointRenderer::setup()
+{
+	release();
+	program = linkProgram(vertexSource, fragmentSource, { "x", "y" });
+	if (program == 0) return false;
+	colorLocation = glGetUniformLocation(program, "color");
+	sizeLocation = glGetUniformLocation(program, "size");
+	radiusLocation = glGetUniformLocation(program, "radius");
+	canvasLocation = glGetUniformLocation(program, "canvas");
+
+	glGenBuffers(2, buffers);
+	storage = hasBufferStorage();
+	return true;
+}
+
+void pointRenderer::upload(const particleBuffer& particles, const uint32_t version)
+{
+	if (!ready() || (filled && version == frame && particles.size() == uploaded)) return;
+	const size_t n = particles.size();
+	const size_t grown = n > capacity ? std::max(n, capacity * 2) : capacity;
+	const float* coordinates[2] = { particles.x.data(), particles.y.data() };
+	for (auto axis = 0; axis < 2; axis++)
+	{
+		// a new store each time, the previous one lives on until its draws are done
+		glBindBuffer(GL_ARRAY_BUFFER, buffers[axis]);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(grown * sizeof(float)), nullptr, GL_STREAM_DRAW);
+		if (n > 0) glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(n * sizeof(float)), coordinates[axis]);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	capacity = grown;
+	uploaded = n;
+	frame = version;
+	filled = true;
+}
+
+void pointRenderer::draw(const particleBuffer& particles, const int type, const float radius, const int alpha, const float width, const float height,
+	const int region) const
+{
+	if (!ready() || type >= particles.types() || (region >= 0 && !streaming())) return;
+	const int first = particles.start[type];
+	const int count = std::min(particles.start[type + 1], static_cast<int>(region >= 0 ? streamed : uploaded)) - first;
+	if (count <= 0) return;
+
+	const particleColor& color = particles.color[type];
+	const float size = 2 * radius + 2;	// the disc and its soft edge
+	glUseProgram(program);
+	glUniform4f(colorLocation, color.r / 255.0F, color.g / 255.0F, color.b / 255.0F, alpha / 255.0F);
+	glUniform1f(sizeLocation, size);
+	glUniform1f(radiusLocation, radius);
+	glUniform2f(canvasLocation, width, height);
+	for (GLuint axis = 0; axis < 2; axis++)
+	{
+		if (region >= 0)
+		{
+			const size_t offset = (2 * static_cast<size_t>(region) + axis) * streamed * sizeof(float);
+			glBindBuffer(GL_ARRAY_BUFFER, stream);
+			glVertexAttribPointer(axis, 1, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const void*>(offset));
+		}
+		else
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, buffers[axis]);
+			glVertexAttribPointer(axis, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+		}
+		glEnableVertexAttribArray(axis);
+	}
+	glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+	glEnable(GL_POINT_SPRITE);
+
+	glDrawArrays(GL_POINTS, first, count);
+
+	// back to the state of the caller
+	glDisable(GL_POINT_SPRITE);
+	glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+	glDisableVertexAttribArray(0);
+	glDisableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUseProgram(0);
+}
+
+void pointRenderer::unmap()
+{
+	for (auto& sync : fences)
+	{
+		if (sync == nullptr) continue;
+		glClientWaitSync(static_cast<GLsync>(sync), GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(static_cast<GLsync>(sync));
+		sync = nullptr;
+	}
+	if (stream != 0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, stream);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &stream);
+	}
+	stream = 0;
+	mapped = nullptr;
+	streamed = 0;
+}
+
+bool pointRenderer::reserve(const size_t particles)
+{
+	if (!ready() || !storage) return false;
+	unmap();
+	generation++;
+	if (particles == 0) return true;
+
+	// coherent: what the writer stores is seen by the next draw without any flush
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr bytes = static_cast<GLsizeiptr>(2 * STREAM_REGIONS * particles * sizeof(float));
+	glGenBuffers(1, &stream);
+	glBindBuffer(GL_ARRAY_BUFFER, stream);
+	glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+	mapped = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (mapped == nullptr)
+	{
+		unmap();
+		storage = false;
+		return false;
+	}
+	streamed = particles;
+	return true;
+}
+
+void pointRenderer::fence(const int region)
+{
+	if (!streaming()) return;
+	if (fences[region] != nullptr) glDeleteSync(static_cast<GLsync>(fences[region]));
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool pointRenderer::idle(const int region)
+{
+	if (fences[region] == nullptr) return true;
+	const GLenum status = glClientWaitSync(static_cast<GLsync>(fences[region]), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+	glDeleteSync(static_cast<GLsync>(fences[region]));
+	fences[region] = nullptr;
+	return true;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "simulation.h"
+
+/*
+ * Point renderer of the particles.
+ * Each group is drawn by a single call as point sprites shaded into discs with the color of the group,
+ * instead of one circle per particle. The positions come from one of two places:
+ *  - the stream: when the context can map a buffer persistently (OpenGL 4.4 or ARB_buffer_storage), a
+ *    buffer of STREAM_REGIONS regions stays mapped for good, and the simulation thread writes the x and y
+ *    arrays of each step straight into the region of its snapshot, without any copy in between. A fence
+ *    is set after the draws of a region, and the region is only handed back to the writer once the GPU
+ *    has passed it, so a region is never written while it is read.
+ *  - the upload: otherwise the x and y arrays of the snapshot are sent to one vertex buffer per
+ *    coordinate, orphaned at every frame so that the driver never waits for the previous draws.
+ * It only needs OpenGL 2.1 and GLSL 1.20 without the stream, and does not depend on the window: it runs in
+ * any context created by the application, including an offscreen one on Mesa's software rasterizer.
+ */
+
+#define STREAM_REGIONS 3 // one region per buffer of the snapshots
+
+class pointRenderer
+{
+public:
+	/**
+	 * @brief Compile the shader and create the buffers, in the current context
+	 *
+	 * @return false when the context has no GLSL 1.20, the renderer is then not usable
+	 */
+	bool setup();
+
+	// true once setup() succeeded
+	bool ready() const { return program != 0; }
+
+	// delete the shader and the buffers, while the context of setup() is still current
+	void release();
+
+	/**
+	 * @brief Send the positions of every group to the vertex buffers
+	 *
+	 * The buffers grow when the particles do not fit, and are only written again for a new frame.
+	 *
+	 * @param particles positions of every group
+	 * @param frame number of the positions, the frame of their step
+	 */
+	void upload(const particleBuffer& particles, uint32_t frame);
+
+	/**
+	 * @brief Draw one group, from the uploaded positions or from a region of the stream
+	 *
+	 * The discs are blended with the blend function of the caller.
+	 *
+	 * @param particles the range and the color of each group, and the uploaded positions
+	 * @param type group to draw
+	 * @param radius radius of the discs in pixels
+	 * @param alpha opacity of the discs, 0 to 255
+	 * @param width width of the canvas in pixels, the origin is at the top left corner
+	 * @param height height of the canvas
+	 * @param region region of the stream holding the positions, -1 for the uploaded ones
+	 */
+	void draw(const particleBuffer& particles, int type, float radius, int alpha, float width, float height, int region = -1) const;
+
+	/**
+	 * @brief Map the stream again with room for more particles
+	 *
+	 * Waits for the GPU to be done with every region. The writer must not touch the stream meanwhile, and
+	 * the positions it held are lost: the generation of the stream changes.
+	 *
+	 * @param particles number of particles of each region
+	 * @return false when the context cannot map a buffer persistently
+	 */
+	bool reserve(size_t particles);
+
+	// the stream is mapped
+	bool streaming() const { return mapped != nullptr; }
+
+	// particles that fit in a region of the stream, 0 without the stream
+	size_t streamCapacity() const { return streamed; }
+
+	// the context can map the stream, reserve() does nothing otherwise
+	bool canStream() const { return ready() && storage; }
+
+	// number of the mapping of the stream, a region written under another generation is lost
+	uint32_t streamGeneration() const { return generation; }
+
+	// mapped x and y of a region, for the writer
+	float* streamX(const int region) const { return mapped + static_cast<size_t>(2 * region) * streamed; }
+	float* streamY(const int region) const { return mapped + static_cast<size_t>(2 * region + 1) * streamed; }
+
+	// set a fence after the draws of a region
+	void fence(int region);
+
+	// true when the GPU is done with the draws of a region, which can then be written again
+	bool idle(int region);
+
+private:
+	void unmap();
+
+	unsigned int program = 0;
+	unsigned int buffers[2] = {};	// x and y of every particle
+	size_t capacity = 0;			// particles that fit in the buffers
+	size_t uploaded = 0;			// particles in the buffers
+	uint32_t frame = 0;				// frame of the uploaded positions
+	bool filled = false;			// the buffers hold a frame
+	int colorLocation = -1;			// uniforms
+	int sizeLocation = -1;
+	int radiusLocation = -1;
+	int canvasLocation = -1;
+
+	bool storage = false;			// the context can map a buffer persistently
+	unsigned int stream = 0;		// STREAM_REGIONS regions of x then y
+	float* mapped = nullptr;
+	size_t streamed = 0;			// particles of each region
+	uint32_t generation = 0;
+	void* fences[STREAM_REGIONS] = {};	// GLsync of the last draws of each region
+};
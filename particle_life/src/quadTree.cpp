@@ -0,0 +1,132 @@
+#include "quadTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void quadTree::build(const float* x, const float* y, const int n)
+{
+	nodes.clear();
+	std::vector<int> order(n);
+	for (auto i = 0; i < n; i++) order[i] = i;
+
+	node root;
+	root.end = n;
+	nodes.push_back(root);
+	if (n > 0) split(0, 0, order, x, y);
+
+	// the leaves become contiguous spans of the position buffers
+	px.assign(n + KERNEL_PADDING, 0.0F);
+	py.assign(n + KERNEL_PADDING, 0.0F);
+	for (auto i = 0; i < n; i++)
+	{
+		px[i] = x[order[i]];
+		py[i] = y[order[i]];
+	}
+}
+
+void quadTree::split(const int index, const int depth, std::vector<int>& order, const float* x, const float* y)
+{
+	const int begin = nodes[index].begin;
+	const int end = nodes[index].end;
+
+	float minX = x[order[begin]];
+	float minY = y[order[begin]];
+	float maxX = minX;
+	float maxY = minY;
+	double sumX = 0;
+	double sumY = 0;
+	for (auto k = begin; k < end; k++)
+	{
+		const float px = x[order[k]];
+		const float py = y[order[k]];
+		minX = std::min(minX, px);
+		maxX = std::max(maxX, px);
+		minY = std::min(minY, py);
+		maxY = std::max(maxY, py);
+		sumX += px;
+		sumY += py;
+	}
+	node& current = nodes[index];
+	current.cx = static_cast<float>(sumX / (end - begin));
+	current.cy = static_cast<float>(sumY / (end - begin));
+	current.minX = minX;
+	current.minY = minY;
+	current.maxX = maxX;
+	current.maxY = maxY;
+
+	if (end - begin <= TREE_LEAF_SIZE || depth >= TREE_MAX_DEPTH || (maxX == minX && maxY == minY)) return;
+
+	// quadrants around the middle of the box: bottom left, bottom right, top left, top right
+	const float midX = (minX + maxX) * 0.5F;
+	const float midY = (minY + maxY) * 0.5F;
+	auto* first = order.data() + begin;
+	auto* last = order.data() + end;
+	auto* top = std::partition(first, last, [&](const int i) { return y[i] < midY; });
+	auto* bottomRight = std::partition(first, top, [&](const int i) { return x[i] < midX; });
+	auto* topRight = std::partition(top, last, [&](const int i) { return x[i] < midX; });
+	const int bounds[5] = {
+		begin,
+		static_cast<int>(bottomRight - order.data()),
+		static_cast<int>(top - order.data()),
+		static_cast<int>(topRight - order.data()),
+		end,
+	};
+
+	const int child = static_cast<int>(nodes.size());
+	nodes[index].child = child;
+	nodes.resize(nodes.size() + 4);
+	for (auto q = 0; q < 4; q++)
+	{
+		nodes[child + q].begin = bounds[q];
+		nodes[child + q].end = bounds[q + 1];
+		if (bounds[q + 1] > bounds[q]) split(child + q, depth + 1, order, x, y);
+	}
+}
+
+void quadTree::force(const float x, const float y, const float theta, const forceKernel kernel, float& fx, float& fy) const
+{
+	if (nodes.empty() || nodes[0].end == 0) return;
+
+	const float theta2 = theta * theta;
+	float sx = 0.0F;
+	float sy = 0.0F;
+
+	int stack[4 * TREE_MAX_DEPTH + 4];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const node& current = nodes[stack[--top]];
+		const int count = current.end - current.begin;
+		if (count == 0) continue;
+
+		const bool inside = x >= current.minX && x <= current.maxX && y >= current.minY && y <= current.maxY;
+		if (!inside)
+		{
+			const float dx = x - current.cx;
+			const float dy = y - current.cy;
+			const float d2 = dx * dx + dy * dy;
+			const float size = std::max(current.maxX - current.minX, current.maxY - current.minY);
+			if (size * size < theta2 * d2)
+			{
+				const float inv = count / std::sqrt(d2);
+				sx += dx * inv;
+				sy += dy * inv;
+				continue;
+			}
+		}
+
+		if (current.child < 0)
+		{
+			kernel(x, y, px.data(), py.data(), current.begin, current.end, std::numeric_limits<float>::infinity(), sx, sy);
+		}
+		else
+		{
+			for (auto q = 3; q >= 0; q--) stack[top++] = current.child + q;
+		}
+	}
+
+	fx += sx;
+	fy += sy;
+}
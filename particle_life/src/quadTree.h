@@ -0,0 +1,68 @@
+#pragma once
+
+#include "simd.h"
+
+#include <vector>
+
+/*
+ * Barnes-Hut quadtree for the infinite radius mode.
+ * The force of a group on a particle is the sum of the unit vectors pointing from each of its points to
+ * the particle. A node seen under a small enough angle is replaced by its point count times the unit
+ * vector pointing from its center of mass, so a query costs O(log N) instead of O(N).
+ */
+
+#define TREE_LEAF_SIZE 16 // points below which a node is not split
+#define TREE_MAX_DEPTH 24 // nodes are not split below this depth (duplicated points)
+
+struct quadTree
+{
+	struct node
+	{
+		// center of mass
+		float cx = 0;
+		float cy = 0;
+		// bounding box of the points
+		float minX = 0;
+		float minY = 0;
+		float maxX = 0;
+		float maxY = 0;
+		// points of the node, stored contiguously
+		int begin = 0;
+		int end = 0;
+		// index of the first of the four children, -1 for a leaf
+		int child = -1;
+	};
+
+	std::vector<node> nodes;
+
+	// points in tree order, padded for the vector kernels
+	std::vector<float> px;
+	std::vector<float> py;
+
+	/**
+	 * @brief Build the tree of a set of points
+	 *
+	 * @param x points x
+	 * @param y points y
+	 * @param n number of points
+	 */
+	void build(const float* x, const float* y, int n);
+
+	/**
+	 * @brief Approximate force of the points of the tree on a position
+	 *
+	 * A node is used as a whole when its size is less than theta times its distance to the position,
+	 * nodes whose box contains the position are always opened. theta = 0 gives the exact force.
+	 *
+	 * @param x position x
+	 * @param y position y
+	 * @param theta opening angle
+	 * @param kernel force kernel used on the leaves
+	 * @param fx sum on x
+	 * @param fy sum on y
+	 */
+	void force(float x, float y, float theta, forceKernel kernel, float& fx, float& fy) const;
+
+private:
+	void split(int index, int depth, std::vector<int>& order, const float* x, const float* y);
+};
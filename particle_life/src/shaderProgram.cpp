@@ -0,0 +1,77 @@
+#include "shaderProgram.h"
+
+#if defined(_WIN32)
+#include <GL/glew.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief Compile one stage of a program
+ *
+ * @return the shader, 0 when it does not compile
+ */
+static GLuint compile(const GLenum type, const char* source)
+{
+	const GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, nullptr);
+	glCompileShader(shader);
+	GLint status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+unsigned int linkProgram(const char* vertexSource, const char* fragmentSource, const std::initializer_list<const char*> attributes)
+{
+	const GLuint vertex = compile(GL_VERTEX_SHADER, vertexSource);
+	const GLuint fragment = compile(GL_FRAGMENT_SHADER, fragmentSource);
+	if (vertex == 0 || fragment == 0)
+	{
+		if (vertex != 0) glDeleteShader(vertex);
+		if (fragment != 0) glDeleteShader(fragment);
+		return 0;
+	}
+
+	const GLuint program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	GLuint location = 0;
+	for (const char* name : attributes) glBindAttribLocation(program, location++, name);
+	glLinkProgram(program);
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+bool hasOpenGL(const int major, const int minor)
+{
+	const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	int contextMajor = 0;
+	int contextMinor = 0;
+	if (version == nullptr || std::sscanf(version, "%d.%d", &contextMajor, &contextMinor) != 2) return false;
+	return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+bool hasExtension(const char* name)
+{
+	// compatibility contexts still list their extensions in a single string
+	const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+	return extensions != nullptr && std::strstr(extensions, name) != nullptr;
+}
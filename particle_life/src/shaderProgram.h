@@ -0,0 +1,24 @@
+#pragma once
+
+#include <initializer_list>
+
+/*
+ * Helpers of the renderers that talk to OpenGL directly, without the wrappers of openFrameworks, so that
+ * they run in any context: the window of the application or an offscreen one.
+ */
+
+/**
+ * @brief Compile and link a program of a vertex and a fragment shader, in the current context
+ *
+ * @param vertexSource source of the vertex stage
+ * @param fragmentSource source of the fragment stage
+ * @param attributes names of the vertex attributes, bound to the locations 0, 1, ...
+ * @return the program, 0 when a stage does not compile or the program does not link
+ */
+unsigned int linkProgram(const char* vertexSource, const char* fragmentSource, std::initializer_list<const char*> attributes);
+
+// the current context has at least this version of OpenGL
+bool hasOpenGL(int major, int minor);
+
+// the current context lists this extension
+bool hasExtension(const char* name);
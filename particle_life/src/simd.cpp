@@ -0,0 +1,659 @@
+#include "simd.h"
+
+#include <cmath>
+
+#ifdef KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+simdLevel detectSimdLevel()
+{
+#ifdef KERNEL_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+	__cpuid(info, 1);
+	const bool sse41 = (info[2] & (1 << 19)) != 0;
+	const bool fma = (info[2] & (1 << 12)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	const bool avxState = (xcr0 & 0x6) == 0x6;		// xmm and ymm registers saved by the OS
+	const bool avx512State = (xcr0 & 0xE6) == 0xE6;	// plus opmask and zmm registers
+	bool avx2 = false;
+	bool avx512 = false;
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+		avx512 = (info[1] & (1 << 16)) != 0;
+	}
+	if (avx512 && avx512State) return simdLevel::avx512;
+	if (avx2 && fma && avxState) return simdLevel::avx2;
+	if (sse41) return simdLevel::sse4;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return simdLevel::avx512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return simdLevel::avx2;
+	if (__builtin_cpu_supports("sse4.1")) return simdLevel::sse4;
+#endif
+#endif
+	return simdLevel::scalar;
+}
+
+const char* simdLevelName(const simdLevel level)
+{
+	switch (level)
+	{
+	case simdLevel::avx512: return "AVX-512";
+	case simdLevel::avx2: return "AVX2";
+	case simdLevel::sse4: return "SSE4";
+	default: return "scalar";
+	}
+}
+
+//------------------------------Force kernels------------------------------
+
+static void forceScalar(const float x, const float y, const float* px, const float* py, const int begin, const int end,
+	const float radius2, float& fx, float& fy)
+{
+	float sx = 0.0F;
+	float sy = 0.0F;
+	for (auto k = begin; k < end; k++)
+	{
+		const float dx = x - px[k];
+		const float dy = y - py[k];
+		const float r2 = dx * dx + dy * dy;
+		if (r2 < radius2 && r2 > 0.0F)
+		{
+			const float inv = 1.0F / std::sqrt(r2);
+			sx += dx * inv;
+			sy += dy * inv;
+		}
+	}
+	fx += sx;
+	fy += sy;
+}
+
+#ifdef KERNEL_X86
+
+KERNEL_TARGET("sse4.1")
+static void forceSse4(const float x, const float y, const float* px, const float* py, const int begin, const int end,
+	const float radius2, float& fx, float& fy)
+{
+	const __m128 vx = _mm_set1_ps(x);
+	const __m128 vy = _mm_set1_ps(y);
+	const __m128 vr2 = _mm_set1_ps(radius2);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5F);
+	const __m128 threeHalves = _mm_set1_ps(1.5F);
+	const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+	const __m128i last = _mm_set1_epi32(end);
+	__m128 sx = zero;
+	__m128 sy = zero;
+
+	for (auto k = begin; k < end; k += 4)
+	{
+		const __m128 dx = _mm_sub_ps(vx, _mm_loadu_ps(px + k));
+		const __m128 dy = _mm_sub_ps(vy, _mm_loadu_ps(py + k));
+		const __m128 r2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+		// lanes past the end of the span read the next cells or the padding
+		const __m128 inside = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32(k), lane), last));
+		const __m128 mask = _mm_and_ps(inside, _mm_and_ps(_mm_cmplt_ps(r2, vr2), _mm_cmpgt_ps(r2, zero)));
+
+		// 1 / sqrt(r2): hardware estimate refined with one Newton step
+		__m128 inv = _mm_rsqrt_ps(r2);
+		inv = _mm_mul_ps(inv, _mm_sub_ps(threeHalves, _mm_mul_ps(_mm_mul_ps(half, r2), _mm_mul_ps(inv, inv))));
+		inv = _mm_and_ps(inv, mask);
+
+		sx = _mm_add_ps(sx, _mm_mul_ps(dx, inv));
+		sy = _mm_add_ps(sy, _mm_mul_ps(dy, inv));
+	}
+
+	sx = _mm_hadd_ps(sx, sy);
+	sx = _mm_hadd_ps(sx, sx);
+	fx += _mm_cvtss_f32(sx);
+	fy += _mm_cvtss_f32(_mm_shuffle_ps(sx, sx, 1));
+}
+
+KERNEL_TARGET("avx2,fma")
+static void forceAvx2(const float x, const float y, const float* px, const float* py, const int begin, const int end,
+	const float radius2, float& fx, float& fy)
+{
+	const __m256 vx = _mm256_set1_ps(x);
+	const __m256 vy = _mm256_set1_ps(y);
+	const __m256 vr2 = _mm256_set1_ps(radius2);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5F);
+	const __m256 threeHalves = _mm256_set1_ps(1.5F);
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i last = _mm256_set1_epi32(end);
+	__m256 sx = zero;
+	__m256 sy = zero;
+
+	for (auto k = begin; k < end; k += 8)
+	{
+		const __m256 dx = _mm256_sub_ps(vx, _mm256_loadu_ps(px + k));
+		const __m256 dy = _mm256_sub_ps(vy, _mm256_loadu_ps(py + k));
+		const __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+
+		// lanes past the end of the span read the next cells or the padding
+		const __m256 inside = _mm256_castsi256_ps(_mm256_cmpgt_epi32(last, _mm256_add_epi32(_mm256_set1_epi32(k), lane)));
+		const __m256 mask = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(r2, vr2, _CMP_LT_OQ), _mm256_cmp_ps(r2, zero, _CMP_GT_OQ)));
+
+		// 1 / sqrt(r2): hardware estimate refined with one Newton step
+		__m256 inv = _mm256_rsqrt_ps(r2);
+		inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(inv, inv), threeHalves));
+		inv = _mm256_and_ps(inv, mask);
+
+		sx = _mm256_fmadd_ps(dx, inv, sx);
+		sy = _mm256_fmadd_ps(dy, inv, sy);
+	}
+
+	__m128 hx = _mm_add_ps(_mm256_castps256_ps128(sx), _mm256_extractf128_ps(sx, 1));
+	__m128 hy = _mm_add_ps(_mm256_castps256_ps128(sy), _mm256_extractf128_ps(sy, 1));
+	hx = _mm_hadd_ps(hx, hy);
+	hx = _mm_hadd_ps(hx, hx);
+	fx += _mm_cvtss_f32(hx);
+	fy += _mm_cvtss_f32(_mm_shuffle_ps(hx, hx, 1));
+}
+
+KERNEL_TARGET("avx512f")
+static void forceAvx512(const float x, const float y, const float* px, const float* py, const int begin, const int end,
+	const float radius2, float& fx, float& fy)
+{
+	const __m512 vx = _mm512_set1_ps(x);
+	const __m512 vy = _mm512_set1_ps(y);
+	const __m512 vr2 = _mm512_set1_ps(radius2);
+	const __m512 zero = _mm512_setzero_ps();
+	const __m512 half = _mm512_set1_ps(0.5F);
+	const __m512 threeHalves = _mm512_set1_ps(1.5F);
+	const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	const __m512i last = _mm512_set1_epi32(end);
+	__m512 sx = zero;
+	__m512 sy = zero;
+
+	for (auto k = begin; k < end; k += 16)
+	{
+		const __m512 dx = _mm512_sub_ps(vx, _mm512_loadu_ps(px + k));
+		const __m512 dy = _mm512_sub_ps(vy, _mm512_loadu_ps(py + k));
+		const __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy));
+
+		// lanes past the end of the span read the next cells or the padding
+		const __mmask16 mask = _mm512_cmplt_epi32_mask(_mm512_add_epi32(_mm512_set1_epi32(k), lane), last)
+			& _mm512_cmp_ps_mask(r2, vr2, _CMP_LT_OQ) & _mm512_cmp_ps_mask(r2, zero, _CMP_GT_OQ);
+
+		// 1 / sqrt(r2): 14 bit estimate refined with one Newton step
+		__m512 inv = _mm512_maskz_rsqrt14_ps(mask, r2);
+		inv = _mm512_mul_ps(inv, _mm512_fnmadd_ps(_mm512_mul_ps(half, r2), _mm512_mul_ps(inv, inv), threeHalves));
+
+		sx = _mm512_mask3_fmadd_ps(dx, inv, sx, mask);
+		sy = _mm512_mask3_fmadd_ps(dy, inv, sy, mask);
+	}
+
+	alignas(64) float lanesX[16];
+	alignas(64) float lanesY[16];
+	_mm512_store_ps(lanesX, sx);
+	_mm512_store_ps(lanesY, sy);
+	for (auto l = 0; l < 16; l++)
+	{
+		fx += lanesX[l];
+		fy += lanesY[l];
+	}
+}
+
+#endif
+
+//------------------------------Pair kernels------------------------------
+
+static void pairScalar(const float x, const float y, const float* px, const float* py, const uint32_t* gates, const int begin, const int end,
+	const float radius2, const float reverseRadius2, const uint32_t reverseBit, float* rx, float* ry, float& fx, float& fy)
+{
+	float sx = 0.0F;
+	float sy = 0.0F;
+	for (auto k = begin; k < end; k++)
+	{
+		const float dx = x - px[k];
+		const float dy = y - py[k];
+		const float r2 = dx * dx + dy * dy;
+		if (r2 <= 0.0F) continue;
+		const bool forward = r2 < radius2;
+		const bool reverse = r2 < reverseRadius2 && (gates[k] & reverseBit) != 0;
+		if (!forward && !reverse) continue;
+
+		const float inv = 1.0F / std::sqrt(r2);
+		if (forward)
+		{
+			sx += dx * inv;
+			sy += dy * inv;
+		}
+		if (reverse)
+		{
+			rx[k] -= dx * inv;
+			ry[k] -= dy * inv;
+		}
+	}
+	fx += sx;
+	fy += sy;
+}
+
+#ifdef KERNEL_X86
+
+KERNEL_TARGET("avx2,fma")
+static void pairAvx2(const float x, const float y, const float* px, const float* py, const uint32_t* gates, const int begin, const int end,
+	const float radius2, const float reverseRadius2, const uint32_t reverseBit, float* rx, float* ry, float& fx, float& fy)
+{
+	const __m256 vx = _mm256_set1_ps(x);
+	const __m256 vy = _mm256_set1_ps(y);
+	const __m256 vr2 = _mm256_set1_ps(radius2);
+	const __m256 vrr2 = _mm256_set1_ps(reverseRadius2);
+	const __m256i bit = _mm256_set1_epi32(static_cast<int>(reverseBit));
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5F);
+	const __m256 threeHalves = _mm256_set1_ps(1.5F);
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i last = _mm256_set1_epi32(end);
+	__m256 sx = zero;
+	__m256 sy = zero;
+
+	for (auto k = begin; k < end; k += 8)
+	{
+		const __m256 dx = _mm256_sub_ps(vx, _mm256_loadu_ps(px + k));
+		const __m256 dy = _mm256_sub_ps(vy, _mm256_loadu_ps(py + k));
+		const __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+
+		// lanes past the end of the span read the next cells or the padding
+		const __m256 inside = _mm256_castsi256_ps(_mm256_cmpgt_epi32(last, _mm256_add_epi32(_mm256_set1_epi32(k), lane)));
+		const __m256 valid = _mm256_and_ps(inside, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ));
+		const __m256 forward = _mm256_and_ps(valid, _mm256_cmp_ps(r2, vr2, _CMP_LT_OQ));
+		const __m256i gate = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gates + k));
+		const __m256 gated = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(gate, bit), bit));
+		const __m256 reverse = _mm256_and_ps(_mm256_and_ps(valid, gated), _mm256_cmp_ps(r2, vrr2, _CMP_LT_OQ));
+
+		// 1 / sqrt(r2): hardware estimate refined with one Newton step
+		__m256 inv = _mm256_rsqrt_ps(r2);
+		inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(inv, inv), threeHalves));
+		const __m256 ux = _mm256_mul_ps(dx, inv);
+		const __m256 uy = _mm256_mul_ps(dy, inv);
+
+		sx = _mm256_add_ps(sx, _mm256_and_ps(ux, forward));
+		sy = _mm256_add_ps(sy, _mm256_and_ps(uy, forward));
+
+		// the lanes that are not written may belong to another thread
+		if (_mm256_movemask_ps(reverse) != 0)
+		{
+			const __m256i store = _mm256_castps_si256(reverse);
+			_mm256_maskstore_ps(rx + k, store, _mm256_sub_ps(_mm256_maskload_ps(rx + k, store), ux));
+			_mm256_maskstore_ps(ry + k, store, _mm256_sub_ps(_mm256_maskload_ps(ry + k, store), uy));
+		}
+	}
+
+	__m128 hx = _mm_add_ps(_mm256_castps256_ps128(sx), _mm256_extractf128_ps(sx, 1));
+	__m128 hy = _mm_add_ps(_mm256_castps256_ps128(sy), _mm256_extractf128_ps(sy, 1));
+	hx = _mm_hadd_ps(hx, hy);
+	hx = _mm_hadd_ps(hx, hx);
+	fx += _mm_cvtss_f32(hx);
+	fy += _mm_cvtss_f32(_mm_shuffle_ps(hx, hx, 1));
+}
+
+#endif
+
+//------------------------------Profile kernels------------------------------
+
+static void profileScalar(const float x, const float y, const float* px, const float* py, const uint32_t* gates, const int begin, const int end,
+	const float radius, const float* profile, const float reverseRadius, const float* reverseProfile, const uint32_t reverseBit,
+	float* rx, float* ry, float& fx, float& fy)
+{
+	const float radius2 = radius * radius;
+	const float reverseRadius2 = reverseRadius * reverseRadius;
+	const float scale = radius > 0.0F ? PROFILE_SAMPLES / radius : 0.0F;
+	const float reverseScale = reverseRadius > 0.0F ? PROFILE_SAMPLES / reverseRadius : 0.0F;
+	float sx = 0.0F;
+	float sy = 0.0F;
+	for (auto k = begin; k < end; k++)
+	{
+		const float dx = x - px[k];
+		const float dy = y - py[k];
+		const float r2 = dx * dx + dy * dy;
+		if (r2 <= 0.0F) continue;
+		const bool forward = r2 < radius2;
+		const bool reverse = r2 < reverseRadius2 && (gates[k] & reverseBit) != 0;
+		if (!forward && !reverse) continue;
+
+		const float inv = 1.0F / std::sqrt(r2);
+		const float r = r2 * inv;
+		if (forward)
+		{
+			const float w = sampleProfile(profile, r * scale);
+			sx += dx * inv * w;
+			sy += dy * inv * w;
+		}
+		if (reverse)
+		{
+			const float w = sampleProfile(reverseProfile, r * reverseScale);
+			rx[k] -= dx * inv * w;
+			ry[k] -= dy * inv * w;
+		}
+	}
+	fx += sx;
+	fy += sy;
+}
+
+#ifdef KERNEL_X86
+
+// profile sampled at t for each lane, t is clamped so that every lane reads inside the samples
+KERNEL_TARGET("avx2,fma")
+static inline __m256 gatherProfile(const float* profile, const __m256 t)
+{
+	const __m256i i = _mm256_cvttps_epi32(_mm256_min_ps(t, _mm256_set1_ps(PROFILE_SAMPLES - 1)));
+	const __m256 low = _mm256_i32gather_ps(profile, i, 4);
+	const __m256 high = _mm256_i32gather_ps(profile + 1, i, 4);
+	return _mm256_fmadd_ps(_mm256_sub_ps(t, _mm256_cvtepi32_ps(i)), _mm256_sub_ps(high, low), low);
+}
+
+KERNEL_TARGET("avx2,fma")
+static void profileAvx2(const float x, const float y, const float* px, const float* py, const uint32_t* gates, const int begin, const int end,
+	const float radius, const float* profile, const float reverseRadius, const float* reverseProfile, const uint32_t reverseBit,
+	float* rx, float* ry, float& fx, float& fy)
+{
+	const __m256 vx = _mm256_set1_ps(x);
+	const __m256 vy = _mm256_set1_ps(y);
+	const __m256 vr2 = _mm256_set1_ps(radius * radius);
+	const __m256 vrr2 = _mm256_set1_ps(reverseRadius * reverseRadius);
+	const __m256 scale = _mm256_set1_ps(radius > 0.0F ? PROFILE_SAMPLES / radius : 0.0F);
+	const __m256 reverseScale = _mm256_set1_ps(reverseRadius > 0.0F ? PROFILE_SAMPLES / reverseRadius : 0.0F);
+	const __m256i bit = _mm256_set1_epi32(static_cast<int>(reverseBit));
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5F);
+	const __m256 threeHalves = _mm256_set1_ps(1.5F);
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i last = _mm256_set1_epi32(end);
+	__m256 sx = zero;
+	__m256 sy = zero;
+
+	for (auto k = begin; k < end; k += 8)
+	{
+		const __m256 dx = _mm256_sub_ps(vx, _mm256_loadu_ps(px + k));
+		const __m256 dy = _mm256_sub_ps(vy, _mm256_loadu_ps(py + k));
+		const __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+
+		// lanes past the end of the span read the next cells or the padding
+		const __m256 inside = _mm256_castsi256_ps(_mm256_cmpgt_epi32(last, _mm256_add_epi32(_mm256_set1_epi32(k), lane)));
+		const __m256 valid = _mm256_and_ps(inside, _mm256_cmp_ps(r2, zero, _CMP_GT_OQ));
+		const __m256 forward = _mm256_and_ps(valid, _mm256_cmp_ps(r2, vr2, _CMP_LT_OQ));
+		const __m256i gate = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gates + k));
+		const __m256 gated = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(gate, bit), bit));
+		const __m256 reverse = _mm256_and_ps(_mm256_and_ps(valid, gated), _mm256_cmp_ps(r2, vrr2, _CMP_LT_OQ));
+		if (_mm256_movemask_ps(_mm256_or_ps(forward, reverse)) == 0) continue;
+
+		// 1 / sqrt(r2): hardware estimate refined with one Newton step
+		__m256 inv = _mm256_rsqrt_ps(r2);
+		inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(inv, inv), threeHalves));
+		const __m256 r = _mm256_mul_ps(r2, inv);
+		const __m256 ux = _mm256_mul_ps(dx, inv);
+		const __m256 uy = _mm256_mul_ps(dy, inv);
+
+		// the lanes out of range may hold any value, even NaN: the clamp keeps their reads inside the samples
+		// and the mask drops them from both factors
+		const __m256 w = _mm256_and_ps(gatherProfile(profile, _mm256_mul_ps(r, scale)), forward);
+		sx = _mm256_fmadd_ps(_mm256_and_ps(ux, forward), w, sx);
+		sy = _mm256_fmadd_ps(_mm256_and_ps(uy, forward), w, sy);
+
+		// the lanes that are not written may belong to another thread
+		if (_mm256_movemask_ps(reverse) != 0)
+		{
+			const __m256 rw = gatherProfile(reverseProfile, _mm256_mul_ps(r, reverseScale));
+			const __m256i store = _mm256_castps_si256(reverse);
+			_mm256_maskstore_ps(rx + k, store, _mm256_fnmadd_ps(ux, rw, _mm256_maskload_ps(rx + k, store)));
+			_mm256_maskstore_ps(ry + k, store, _mm256_fnmadd_ps(uy, rw, _mm256_maskload_ps(ry + k, store)));
+		}
+	}
+
+	__m128 hx = _mm_add_ps(_mm256_castps256_ps128(sx), _mm256_extractf128_ps(sx, 1));
+	__m128 hy = _mm_add_ps(_mm256_castps256_ps128(sy), _mm256_extractf128_ps(sy, 1));
+	hx = _mm_hadd_ps(hx, hy);
+	hx = _mm_hadd_ps(hx, hx);
+	fx += _mm_cvtss_f32(hx);
+	fy += _mm_cvtss_f32(_mm_shuffle_ps(hx, hx, 1));
+}
+
+#endif
+
+//------------------------------List kernels------------------------------
+
+// index of the lowest bit set, the mask is not 0
+static inline int lowestBit(const unsigned mask)
+{
+#if defined(_MSC_VER)
+	unsigned long b;
+	_BitScanForward(&b, mask);
+	return static_cast<int>(b);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static int listScalar(const float x, const float y, const float* px, const float* py, const int* items, const int begin, const int end,
+	const float radius2, const float halfWidth, const float halfHeight, const int skip, int* out)
+{
+	int n = 0;
+	for (auto k = begin; k < end; k++)
+	{
+		const float dx = x - px[k];
+		const float dy = y - py[k];
+
+		// every item is written, only the count moves past the ones in range
+		out[n] = items[k];
+		n += (dx * dx + dy * dy < radius2) & (std::abs(dx) <= halfWidth) & (std::abs(dy) <= halfHeight) & (k != skip);
+	}
+	return n;
+}
+
+#ifdef KERNEL_X86
+
+KERNEL_TARGET("avx2,fma")
+static int listAvx2(const float x, const float y, const float* px, const float* py, const int* items, const int begin, const int end,
+	const float radius2, const float halfWidth, const float halfHeight, const int skip, int* out)
+{
+	const __m256 vx = _mm256_set1_ps(x);
+	const __m256 vy = _mm256_set1_ps(y);
+	const __m256 vr2 = _mm256_set1_ps(radius2);
+	const __m256 hw = _mm256_set1_ps(halfWidth);
+	const __m256 hh = _mm256_set1_ps(halfHeight);
+	const __m256 sign = _mm256_set1_ps(-0.0F);
+	int n = 0;
+
+	for (auto k = begin; k < end; k += 8)
+	{
+		const __m256 dx = _mm256_sub_ps(vx, _mm256_loadu_ps(px + k));
+		const __m256 dy = _mm256_sub_ps(vy, _mm256_loadu_ps(py + k));
+		const __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+		const __m256 inside = _mm256_and_ps(_mm256_cmp_ps(r2, vr2, _CMP_LT_OQ),
+			_mm256_and_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign, dx), hw, _CMP_LE_OQ), _mm256_cmp_ps(_mm256_andnot_ps(sign, dy), hh, _CMP_LE_OQ)));
+
+		// lanes past the end of the span read the next cells or the padding
+		unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(inside)) & (end - k < 8 ? (1U << (end - k)) - 1U : 0xFFU);
+		if (skip >= k && skip < k + 8) bits &= ~(1U << (skip - k));
+		for (; bits != 0; bits &= bits - 1) out[n++] = items[k + lowestBit(bits)];
+	}
+	return n;
+}
+
+KERNEL_TARGET("avx512f,popcnt")
+static int listAvx512(const float x, const float y, const float* px, const float* py, const int* items, const int begin, const int end,
+	const float radius2, const float halfWidth, const float halfHeight, const int skip, int* out)
+{
+	const __m512 vx = _mm512_set1_ps(x);
+	const __m512 vy = _mm512_set1_ps(y);
+	const __m512 vr2 = _mm512_set1_ps(radius2);
+	const __m512 hw = _mm512_set1_ps(halfWidth);
+	const __m512 hh = _mm512_set1_ps(halfHeight);
+	int n = 0;
+
+	for (auto k = begin; k < end; k += 16)
+	{
+		const __m512 dx = _mm512_sub_ps(vx, _mm512_loadu_ps(px + k));
+		const __m512 dy = _mm512_sub_ps(vy, _mm512_loadu_ps(py + k));
+		const __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy));
+
+		// lanes past the end of the span read the next cells or the padding, the items are not padded
+		__mmask16 mask = end - k < 16 ? static_cast<__mmask16>((1U << (end - k)) - 1U) : static_cast<__mmask16>(0xFFFF);
+		if (skip >= k && skip < k + 16) mask &= static_cast<__mmask16>(~(1U << (skip - k)));
+		mask &= _mm512_cmp_ps_mask(r2, vr2, _CMP_LT_OQ) & _mm512_cmp_ps_mask(_mm512_abs_ps(dx), hw, _CMP_LE_OQ)
+			& _mm512_cmp_ps_mask(_mm512_abs_ps(dy), hh, _CMP_LE_OQ);
+		_mm512_mask_compressstoreu_epi32(out + n, mask, _mm512_maskz_loadu_epi32(mask, items + k));
+		n += static_cast<int>(_mm_popcnt_u32(mask));
+	}
+	return n;
+}
+
+#endif
+
+//------------------------------Neighbour kernels------------------------------
+
+static void neighbourScalar(const float x, const float y, const float* px, const float* py, const int* items, const int count,
+	const float radius, const float* profile, const float width, const float height, float& fx, float& fy)
+{
+	const float radius2 = radius * radius;
+	const float scale = PROFILE_SAMPLES / radius;
+	float sx = 0.0F;
+	float sy = 0.0F;
+	for (auto n = 0; n < count; n++)
+	{
+		float dx = x - px[items[n]];
+		float dy = y - py[items[n]];
+		if (width > 0.0F)
+		{
+			dx -= width * std::floor(dx / width + 0.5F);
+			dy -= height * std::floor(dy / height + 0.5F);
+		}
+		const float r2 = dx * dx + dy * dy;
+		if (r2 >= radius2 || r2 <= 0.0F) continue;
+
+		const float inv = 1.0F / std::sqrt(r2);
+		const float w = profile != nullptr ? sampleProfile(profile, r2 * inv * scale) : 1.0F;
+		sx += dx * inv * w;
+		sy += dy * inv * w;
+	}
+	fx += sx;
+	fy += sy;
+}
+
+#ifdef KERNEL_X86
+
+KERNEL_TARGET("avx2,fma")
+static void neighbourAvx2(const float x, const float y, const float* px, const float* py, const int* items, const int count,
+	const float radius, const float* profile, const float width, const float height, float& fx, float& fy)
+{
+	const __m256 vx = _mm256_set1_ps(x);
+	const __m256 vy = _mm256_set1_ps(y);
+	const __m256 vr2 = _mm256_set1_ps(radius * radius);
+	const __m256 scale = _mm256_set1_ps(PROFILE_SAMPLES / radius);
+	const __m256 vw = _mm256_set1_ps(width);
+	const __m256 vh = _mm256_set1_ps(height);
+	const __m256 invW = _mm256_set1_ps(width > 0.0F ? 1.0F / width : 0.0F);
+	const __m256 invH = _mm256_set1_ps(height > 0.0F ? 1.0F / height : 0.0F);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps(0.5F);
+	const __m256 threeHalves = _mm256_set1_ps(1.5F);
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i last = _mm256_set1_epi32(count);
+	__m256 sx = zero;
+	__m256 sy = zero;
+
+	for (auto n = 0; n < count; n += 8)
+	{
+		// the lanes past the end of the list read the first point
+		const __m256i inside = _mm256_cmpgt_epi32(last, _mm256_add_epi32(_mm256_set1_epi32(n), lane));
+		const __m256i index = _mm256_maskload_epi32(items + n, inside);
+		__m256 dx = _mm256_sub_ps(vx, _mm256_i32gather_ps(px, index, 4));
+		__m256 dy = _mm256_sub_ps(vy, _mm256_i32gather_ps(py, index, 4));
+		if (width > 0.0F)
+		{
+			dx = _mm256_fnmadd_ps(vw, _mm256_floor_ps(_mm256_fmadd_ps(dx, invW, half)), dx);
+			dy = _mm256_fnmadd_ps(vh, _mm256_floor_ps(_mm256_fmadd_ps(dy, invH, half)), dy);
+		}
+		const __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+		const __m256 forward = _mm256_and_ps(_mm256_castsi256_ps(inside),
+			_mm256_and_ps(_mm256_cmp_ps(r2, zero, _CMP_GT_OQ), _mm256_cmp_ps(r2, vr2, _CMP_LT_OQ)));
+
+		// 1 / sqrt(r2): hardware estimate refined with one Newton step
+		__m256 inv = _mm256_rsqrt_ps(r2);
+		inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(inv, inv), threeHalves));
+		__m256 ux = _mm256_and_ps(_mm256_mul_ps(dx, inv), forward);
+		__m256 uy = _mm256_and_ps(_mm256_mul_ps(dy, inv), forward);
+		if (profile != nullptr)
+		{
+			// the clamp keeps the reads of the lanes out of range inside the samples
+			const __m256 w = _mm256_and_ps(gatherProfile(profile, _mm256_mul_ps(_mm256_mul_ps(r2, inv), scale)), forward);
+			ux = _mm256_mul_ps(ux, w);
+			uy = _mm256_mul_ps(uy, w);
+		}
+		sx = _mm256_add_ps(sx, ux);
+		sy = _mm256_add_ps(sy, uy);
+	}
+
+	__m128 hx = _mm_add_ps(_mm256_castps256_ps128(sx), _mm256_extractf128_ps(sx, 1));
+	__m128 hy = _mm_add_ps(_mm256_castps256_ps128(sy), _mm256_extractf128_ps(sy, 1));
+	hx = _mm_hadd_ps(hx, hy);
+	hx = _mm_hadd_ps(hx, hx);
+	fx += _mm_cvtss_f32(hx);
+	fy += _mm_cvtss_f32(_mm_shuffle_ps(hx, hx, 1));
+}
+
+#endif
+
+forceKernel getForceKernel(const simdLevel level)
+{
+#ifdef KERNEL_X86
+	switch (level)
+	{
+	case simdLevel::avx512: return forceAvx512;
+	case simdLevel::avx2: return forceAvx2;
+	case simdLevel::sse4: return forceSse4;
+	default: break;
+	}
+#endif
+	return forceScalar;
+}
+
+pairKernel getPairKernel(const simdLevel level)
+{
+#ifdef KERNEL_X86
+	if (level >= simdLevel::avx2) return pairAvx2;
+#endif
+	return pairScalar;
+}
+
+profileKernel getProfileKernel(const simdLevel level)
+{
+#ifdef KERNEL_X86
+	if (level >= simdLevel::avx2) return profileAvx2;
+#endif
+	return profileScalar;
+}
+
+listKernel getListKernel(const simdLevel level)
+{
+#ifdef KERNEL_X86
+	switch (level)
+	{
+	case simdLevel::avx512: return listAvx512;
+	case simdLevel::avx2: return listAvx2;
+	default: break;
+	}
+#endif
+	return listScalar;
+}
+
+neighbourKernel getNeighbourKernel(const simdLevel level)
+{
+#ifdef KERNEL_X86
+	if (level >= simdLevel::avx2) return neighbourAvx2;
+#endif
+	return neighbourScalar;
+}
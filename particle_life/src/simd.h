@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Vectorized kernels with runtime cpu dispatch.
+ * Every kernel has a scalar version, the SSE4, AVX2 and AVX-512 versions are only used when the cpu
+ * (and the OS) supports them, so the same binary runs everywhere.
+ */
+
+// Number of entries allocated after the last position of a padded buffer.
+// The vector kernels load full registers and mask the lanes past the end of the span they process.
+#define KERNEL_PADDING 16
+
+// Intervals of a force profile over [0, radius], the profile holds PROFILE_SAMPLES + 1 samples.
+#define PROFILE_SAMPLES 256
+
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KERNEL_X86 1
+#endif
+
+enum class simdLevel
+{
+	scalar,
+	sse4,
+	avx2,
+	avx512,
+};
+
+/**
+ * @brief Best instruction set supported by this cpu and OS
+ */
+simdLevel detectSimdLevel();
+
+/**
+ * @brief Printable name of an instruction set
+ */
+const char* simdLevelName(simdLevel level);
+
+/**
+ * @brief Force of a span of points on a position
+ *
+ * Adds to fx, fy the sum of the unit vectors pointing from the points [begin, end) of a padded position
+ * buffer to (x, y), for every point with 0 < distance^2 < radius2. Pass an infinite radius2 for no limit.
+ */
+typedef void (*forceKernel)(float x, float y, const float* px, const float* py, int begin, int end, float radius2, float& fx, float& fy);
+
+/**
+ * @brief Force kernel for the given instruction set
+ */
+forceKernel getForceKernel(simdLevel level);
+
+/**
+ * @brief Forces between a position and a span of points, in both directions
+ *
+ * Adds to fx, fy the force of the span on (x, y) like a forceKernel with radius2, and from the same
+ * distances subtracts the unit vector from rx[k], ry[k] for every point k of the span with
+ * 0 < distance^2 < reverseRadius2 and (gates[k] & reverseBit) set. Only the entries of the span are
+ * written, so spans handled by other threads can share the accumulators.
+ */
+typedef void (*pairKernel)(float x, float y, const float* px, const float* py, const uint32_t* gates, int begin, int end,
+	float radius2, float reverseRadius2, uint32_t reverseBit, float* rx, float* ry, float& fx, float& fy);
+
+/**
+ * @brief Pair kernel for the given instruction set (AVX2 or scalar, the writes need masked stores)
+ */
+pairKernel getPairKernel(simdLevel level);
+
+/**
+ * @brief Value of a force profile, linearly interpolated between its samples
+ *
+ * @param profile PROFILE_SAMPLES + 1 samples over [0, radius]
+ * @param t distance * PROFILE_SAMPLES / radius, from 0 to PROFILE_SAMPLES
+ */
+inline float sampleProfile(const float* profile, const float t)
+{
+	const int i = t < PROFILE_SAMPLES - 1 ? static_cast<int>(t) : PROFILE_SAMPLES - 1;
+	return profile[i] + (t - i) * (profile[i + 1] - profile[i]);
+}
+
+/**
+ * @brief Forces between a position and a span of points, in both directions, shaped by force profiles
+ *
+ * Same as a pairKernel, with the radii not squared, except that every unit vector is scaled by the profile
+ * of its direction sampled at its distance. With a reverse radius of 0 nothing is written to rx, ry.
+ */
+typedef void (*profileKernel)(float x, float y, const float* px, const float* py, const uint32_t* gates, int begin, int end,
+	float radius, const float* profile, float reverseRadius, const float* reverseProfile, uint32_t reverseBit, float* rx, float* ry,
+	float& fx, float& fy);
+
+/**
+ * @brief Profile kernel for the given instruction set (AVX2 or scalar, the samples are gathered)
+ */
+profileKernel getProfileKernel(simdLevel level);
+
+/**
+ * @brief Points of a span in range of a position
+ *
+ * Writes to out the items[k] of the points k of [begin, end) of a padded position buffer with
+ * distance^2 < radius2, |dx| <= halfWidth and |dy| <= halfHeight, except the point skip, and returns their
+ * number. out must have room for end - begin entries, items does not need padding.
+ */
+typedef int (*listKernel)(float x, float y, const float* px, const float* py, const int* items, int begin, int end,
+	float radius2, float halfWidth, float halfHeight, int skip, int* out);
+
+/**
+ * @brief List kernel for the given instruction set
+ */
+listKernel getListKernel(simdLevel level);
+
+/**
+ * @brief Force of a list of points on a position
+ *
+ * Adds to fx, fy the sum of the unit vectors pointing from the points px[items[n]], py[items[n]] to (x, y),
+ * for every point with 0 < distance < radius, scaled by the profile sampled at the distance when there is
+ * one. With a width > 0 the distances are taken to the nearest image on a width x height torus.
+ */
+typedef void (*neighbourKernel)(float x, float y, const float* px, const float* py, const int* items, int count,
+	float radius, const float* profile, float width, float height, float& fx, float& fy);
+
+/**
+ * @brief Neighbour kernel for the given instruction set (AVX2 or scalar, the points are gathered)
+ */
+neighbourKernel getNeighbourKernel(simdLevel level);
@@ -0,0 +1,1108 @@
+#include "simulation.h"
+#include "simd.h"
+#include "counterRng.h"
+#include "spatialSort.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//Vectorized force kernels, picked once for the cpu we run on
+const simdLevel kernelLevel = detectSimdLevel();
+const forceKernel forceSpan = getForceKernel(kernelLevel);
+const pairKernel pairSpan = getPairKernel(kernelLevel);
+const profileKernel profileSpan = getProfileKernel(kernelLevel);
+const listKernel listSpan = getListKernel(kernelLevel);
+const neighbourKernel neighbourSpan = getNeighbourKernel(kernelLevel);
+
+/**
+ * @brief Uniform random number in [0, 1), from the top 24 bits of a draw
+ */
+static float uniform(std::mt19937_64& rng)
+{
+	return static_cast<float>(rng() >> 40) * (1.0F / 16777216.0F);
+}
+
+/**
+ * @brief Append a number of single colored points randomly distributed on canvas
+ *
+ * @param points buffer receiving the points, at its end
+ * @param type group of the points
+ * @param num number of point to generate
+ * @param width canvas width
+ * @param height canvas height
+ * @param rng random numbers of the run
+ */
+static void CreatePoints(particleBuffer& points, const int type, const int num, const int width, const int height, std::mt19937_64& rng)
+{
+	for (auto i = 0; i < num; i++)
+	{
+		points.x.push_back(static_cast<int>(uniform(rng) * width));
+		points.y.push_back(static_cast<int>(uniform(rng) * height));
+		points.vx.push_back(0.0F);
+		points.vy.push_back(0.0F);
+		points.id.push_back(i);
+	}
+	points.color[type].r = static_cast<unsigned char>(uniform(rng) * 256);
+	points.color[type].g = static_cast<unsigned char>(uniform(rng) * 256);
+	points.color[type].b = static_cast<unsigned char>(uniform(rng) * 256);
+}
+
+simulation::simulation(const int threads) : pool(threads)
+{
+}
+
+void simulation::restart(const int* count, const int types, const int width, const int height, const uint64_t key)
+{
+	seed = key;
+	frame = 0;
+	neighbours.valid = false;
+	std::mt19937_64 rng(key);
+
+	// the buffer is filled again group after group, the groups without a count copy their particles over
+	const int n = std::min(std::max(types, 1), TYPE_MAX);
+	particleBuffer next;
+	next.color.resize(n);
+	next.start.assign(n + 1, 0);
+	for (auto t = 0; t < n; t++)
+	{
+		if (count[t] > 0)
+		{
+			CreatePoints(next, t, count[t], width, height, rng);
+		}
+		else if (t < particles.types())
+		{
+			const auto first = particles.start[t];
+			const auto last = particles.start[t + 1];
+			next.x.insert(next.x.end(), particles.x.begin() + first, particles.x.begin() + last);
+			next.y.insert(next.y.end(), particles.y.begin() + first, particles.y.begin() + last);
+			next.vx.insert(next.vx.end(), particles.vx.begin() + first, particles.vx.begin() + last);
+			next.vy.insert(next.vy.end(), particles.vy.begin() + first, particles.vy.begin() + last);
+			next.id.insert(next.id.end(), particles.id.begin() + first, particles.id.begin() + last);
+			next.color[t] = particles.color[t];
+		}
+		next.start[t + 1] = static_cast<int>(next.size());
+	}
+	particles = std::move(next);
+	subdiv.resize(n);
+	trees.resize(n);
+}
+
+/**
+ * @brief Change the number of groups of the table
+ *
+ * @param n new number of groups
+ */
+void pairTable::resize(const int n)
+{
+	std::vector<float> resized(static_cast<size_t>(n) * n, 0.0F);
+	const int kept = std::min(n, types);
+	for (auto a = 0; a < kept; a++) std::copy_n(values.data() + static_cast<size_t>(a) * types, kept, resized.data() + static_cast<size_t>(a) * n);
+	types = n;
+	values.swap(resized);
+}
+
+void interactionMatrix::resize(const int n)
+{
+	power.resize(n);
+	radius.resize(n);
+	viscosity.resize(n);
+	probability.resize(n);
+	falloff.resize(n);
+	core.resize(n);
+}
+
+/**
+ * @brief Size the grid so that its cells tile the canvas and are not smaller than the given radius
+ *
+ * @param radius largest interaction radius in use
+ * @param canvasWidth canvas width
+ * @param canvasHeight canvas height
+ * @param wrap fill the halo with the ghosts of the opposite borders
+ */
+void grid::setup(const float radius, const int canvasWidth, const int canvasHeight, const bool wrap)
+{
+	// the cell count is capped, very small radii would otherwise allocate millions of empty cells
+	const float minCell = std::sqrt(static_cast<float>(canvasWidth) * static_cast<float>(canvasHeight) / GRID_MAX_CELLS);
+	const float size = std::max({ radius, minCell, 1.0F });
+	width = static_cast<float>(std::max(canvasWidth, 1));
+	height = static_cast<float>(std::max(canvasHeight, 1));
+	cols = std::max(static_cast<int>(width / size), 1);
+	rows = std::max(static_cast<int>(height / size), 1);
+	cellWidth = width / cols;
+	cellHeight = height / rows;
+	periodic = wrap;
+}
+
+/**
+ * @brief Sort the indices of a group of points by cell (counting sort)
+ *
+ * In a periodic grid, the points of the border cells are also copied in the halo on the other side.
+ *
+ * @param x positions of the points of the group
+ * @param y
+ * @param n number of points
+ * @param types number of groups, one force buffer each
+ */
+void grid::build(const float* x, const float* y, const int n, const int types)
+{
+	const int cellCount = (cols + 2) * (rows + 2);
+
+	// cell of each image of a point: itself first, then its ghosts
+	auto images = [&](const int i, auto&& visit)
+	{
+		const int cx = cellX(x[i]);
+		const int cy = cellY(y[i]);
+		visit(cell(cx, cy), 0, 0);
+		if (!periodic) return;
+		for (auto iy = -1; iy <= 1; iy++)
+		{
+			if ((iy == 1 && cy != 0) || (iy == -1 && cy != rows - 1)) continue;
+			for (auto ix = -1; ix <= 1; ix++)
+			{
+				if ((ix == 1 && cx != 0) || (ix == -1 && cx != cols - 1) || (ix == 0 && iy == 0)) continue;
+				visit(cell(ix == 1 ? cols : ix == -1 ? -1 : cx, iy == 1 ? rows : iy == -1 ? -1 : cy), ix, iy);
+			}
+		}
+	};
+
+	cellStart.assign(cellCount + 1, 0);
+	for (auto i = 0; i < n; i++) images(i, [&](const int c, int, int) { cellStart[c + 1]++; });
+	for (auto c = 0; c < cellCount; c++) cellStart[c + 1] += cellStart[c];
+	const int entries = cellStart[cellCount];
+
+	// the padding lets the vector kernels load full registers past the last position
+	cellItems.resize(entries);
+	slots.resize(n);
+	ghosts.clear();
+	px.assign(entries + KERNEL_PADDING, 0.0F);
+	py.assign(entries + KERNEL_PADDING, 0.0F);
+	gates.assign(entries + KERNEL_PADDING, 0);
+	fx.assign(static_cast<size_t>(entries + KERNEL_PADDING) * types, 0.0F);
+	fy.assign(static_cast<size_t>(entries + KERNEL_PADDING) * types, 0.0F);
+	std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+	scattered = 0;
+	for (auto i = 0; i < n; i++)
+	{
+		if (i > 0 && (std::abs(cellX(x[i]) - cellX(x[i - 1])) > 1 || std::abs(cellY(y[i]) - cellY(y[i - 1])) > 1)) scattered++;
+
+		images(i, [&](const int c, const int ix, const int iy)
+		{
+			const int slot = fill[c]++;
+			cellItems[slot] = i;
+			px[slot] = x[i] + ix * width;
+			py[slot] = y[i] + iy * height;
+			if (ix == 0 && iy == 0) slots[i] = slot;
+			else ghosts.push_back(slot);
+		});
+	}
+}
+
+/**
+ * @brief Sort the buffers of a group along the Z-order curve of the grid cells
+ *
+ * @param pool threads of the sort
+ * @param points the buffer holding the group
+ * @param first first particle of the group
+ * @param n number of particles to sort
+ * @param cells grid giving the cells
+ */
+static void reorder(threadPool& pool, particleBuffer& points, const int first, const int n, const grid& cells)
+{
+	const int tiles = (n + TILE_SIZE - 1) / TILE_SIZE;
+	std::vector<uint32_t> keys(n);
+	std::vector<int> order(n);
+	pool.run({ { tiles, [&](const int tile)
+	{
+		for (auto i = tile * TILE_SIZE; i < std::min(n, (tile + 1) * TILE_SIZE); i++)
+		{
+			keys[i] = mortonCode(cells.cellX(points.x[first + i]), cells.cellY(points.y[first + i]));
+			order[i] = i;
+		}
+	} } });
+	radixSort(pool, keys, order);
+
+	// the particles are gathered in their new order, then copied back
+	std::vector<float> x(n);
+	std::vector<float> y(n);
+	std::vector<float> vx(n);
+	std::vector<float> vy(n);
+	std::vector<int> id(n);
+	pool.run({ { tiles, [&](const int tile)
+	{
+		for (auto i = tile * TILE_SIZE; i < std::min(n, (tile + 1) * TILE_SIZE); i++)
+		{
+			const int from = first + order[i];
+			x[i] = points.x[from];
+			y[i] = points.y[from];
+			vx[i] = points.vx[from];
+			vy[i] = points.vy[from];
+			id[i] = points.id[from];
+		}
+	} }, { tiles, [&](const int tile)
+	{
+		const int begin = tile * TILE_SIZE;
+		const int count = std::min(n, begin + TILE_SIZE) - begin;
+		std::copy_n(x.begin() + begin, count, points.x.begin() + first + begin);
+		std::copy_n(y.begin() + begin, count, points.y.begin() + first + begin);
+		std::copy_n(vx.begin() + begin, count, points.vx.begin() + first + begin);
+		std::copy_n(vy.begin() + begin, count, points.vy.begin() + first + begin);
+		std::copy_n(id.begin() + begin, count, points.id.begin() + first + begin);
+	} } });
+}
+
+/**
+ * @brief Group of a particle of the single range of all the groups
+ *
+ * @param start first particle of each group, and the total at the end
+ * @param k index in the range
+ */
+static inline int groupOf(const int* start, const int k)
+{
+	auto a = 0;
+	while (k >= start[a + 1]) a++;
+	return a;
+}
+
+/**
+ * @brief Tell if the lists no longer match the particles or the parameters
+ *
+ * They do not when the particle counts, the radii, the wanted skin, the pairs that interact or the wrapping
+ * of the positions have changed, whatever the particles did.
+ *
+ * @param count number of active particles of each group
+ * @param forced groups whose force on each group is computed
+ * @param matrix parameters of the pairs
+ * @param margin skin wanted for the lists, 0 for the automatic one
+ * @param wrap the positions wrap around the canvas
+ */
+bool verletList::changed(const int* count, const groupMask* forced, const interactionMatrix& matrix, const float margin, const bool wrap) const
+{
+	if (!valid || (margin > 0.0F && margin != skin) || wrap != wrapped || types != matrix.types()) return true;
+	for (auto a = 0; a < types; a++)
+	{
+		if (refCount[a] != count[a]) return true;
+		for (auto b = 0; b < types; b++)
+		{
+			const bool listed = (forced[a] >> b) & 1;
+			if (cutoff[a][b] != (listed ? matrix.radius[a][b] + skin : 0.0F)) return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Largest displacement of a tile of particles since the build, to the nearest image when they wrap
+ *
+ * @param tile tile of TILE_SIZE active particles
+ * @param particles the particles of every group
+ * @param start first active particle of each group in the range of the tiles
+ */
+void verletList::measure(const int tile, const particleBuffer& particles, const int* start)
+{
+	float moved = 0.0F;
+	for (auto k = tile * TILE_SIZE; k < std::min(start[types], (tile + 1) * TILE_SIZE); k++)
+	{
+		const int a = groupOf(start, k);
+		const int p = particles.start[a] + k - start[a];
+		float dx = particles.x[p] - refX[k];
+		float dy = particles.y[p] - refY[k];
+		if (wrapped)
+		{
+			dx -= width * std::floor(dx / width + 0.5F);
+			dy -= height * std::floor(dy / height + 0.5F);
+		}
+		moved = std::max(moved, dx * dx + dy * dy);
+	}
+	tileMoved[tile] = moved;
+}
+
+/**
+ * @brief Decide if the lists are built again by this step, and prepare them if they are
+ *
+ * They are when a particle moved by more than half of the skin since the last build, or when they no longer
+ * match the particles or the parameters. The displacement also gives the speed of the automatic skin.
+ *
+ * @param structure the lists no longer match, the displacements were not measured
+ * @param tiles number of tiles of particles
+ * @param count number of active particles of each group
+ * @param forced groups whose force on each group is computed, the other pairs are not listed
+ * @param matrix parameters of the pairs
+ * @param margin skin of the build, the grids have cells at least as large as the radii plus the skin
+ * @param cells grid of the first group, for the canvas and its wrapping
+ */
+void verletList::decide(const bool structure, const int tiles, const int* count, const groupMask* forced, const interactionMatrix& matrix, const float margin,
+	const grid& cells)
+{
+	rebuild = structure;
+	if (!structure)
+	{
+		const float moved = tiles > 0 ? *std::max_element(tileMoved.begin(), tileMoved.begin() + tiles) : 0.0F;
+		age++;
+		speed = std::sqrt(moved) / age;
+		rebuild = 4.0F * moved > skin * skin;
+	}
+	if (!rebuild) return;
+
+	types = matrix.types();
+	skin = margin;
+	width = cells.width;
+	height = cells.height;
+	wrapped = cells.periodic;
+	age = 0;
+	builds++;
+	valid = true;
+	refCount.assign(count, count + types);
+	cutoff.resize(types);
+	int total = 0;
+	for (auto a = 0; a < types; a++)
+	{
+		total += count[a];
+		for (auto b = 0; b < types; b++) cutoff[a][b] = (forced[a] >> b) & 1 ? matrix.radius[a][b] + skin : 0.0F;
+	}
+	refX.resize(total);
+	refY.resize(total);
+	offsets.resize(static_cast<size_t>(total) * types + 1);
+	tileItems.resize(tiles);
+	tileLists.resize(tiles);
+}
+
+/**
+ * @brief Append the neighbours of an active particle in one group, found in the grid of that group
+ *
+ * Ghosts are listed as their particle, the force finds the nearest image again.
+ *
+ * @param k index of the particle in the range of the tiles
+ * @param a its group
+ * @param i its index in its group
+ * @param b acting group
+ * @param other grid of the acting group
+ * @param list neighbours found so far by the tile, grown as needed
+ * @param n number of neighbours in the list, updated
+ */
+void verletList::search(const int k, const int a, const int i, const int b, const grid& other, std::vector<int>& list, int& n) const
+{
+	const float x = refX[k];
+	const float y = refY[k];
+	const float cutoff2 = cutoff[a][b] * cutoff[a][b];
+	const int self = a == b ? other.slots[i] : -1;
+
+	// a particle is listed once, from its nearest image
+	const float halfWidth = other.periodic ? 0.5F * other.width : INFINITY;
+	const float halfHeight = other.periodic ? 0.5F * other.height : INFINITY;
+	const int cx = other.cellX(x);
+	const int cy = other.cellY(y);
+	for (auto row = cy - 1; row <= cy + 1; row++)
+	{
+		const int first = other.cellStart[other.cell(cx - 1, row)];
+		const int end = other.cellStart[other.cell(cx + 1, row) + 1];
+		if (static_cast<int>(list.size()) < n + end - first) list.resize(2 * (n + end - first));
+		n += listSpan(x, y, other.px.data(), other.py.data(), other.cellItems.data(), first, end, cutoff2, halfWidth, halfHeight, self, list.data() + n);
+	}
+}
+
+/**
+ * @brief Search of a build: list the neighbours of a tile of particles in every pair, in the buffer of the tile
+ *
+ * The rows of the tile are numbered from the start of its buffer until the tiles before it are known.
+ *
+ * @param tile tile of TILE_SIZE active particles
+ * @param cells grid of each group
+ * @param start first active particle of each group in the range of the tiles
+ * @param forced groups whose force on each group is computed
+ */
+void verletList::searchTile(const int tile, const grid* cells, const int* start, const groupMask* forced)
+{
+	if (!rebuild) return;
+	std::vector<int>& list = tileLists[tile];
+	int n = 0;
+	for (auto k = tile * TILE_SIZE; k < std::min(start[types], (tile + 1) * TILE_SIZE); k++)
+	{
+		const int a = groupOf(start, k);
+		const int i = k - start[a];
+		const int slot = cells[a].slots[i];
+		refX[k] = cells[a].px[slot];
+		refY[k] = cells[a].py[slot];
+		for (auto b = 0; b < types; b++)
+		{
+			offsets[static_cast<size_t>(k) * types + b] = n;
+			if ((forced[a] >> b) & 1) search(k, a, i, b, cells[b], list, n);
+		}
+	}
+	tileItems[tile] = n;
+}
+
+/**
+ * @brief Place the neighbours of each tile after those of the tiles before it
+ *
+ * @param tiles number of tiles of particles
+ * @param total number of active particles
+ */
+void verletList::place(const int tiles, const int total)
+{
+	if (!rebuild) return;
+	int offset = 0;
+	for (auto tile = 0; tile < tiles; tile++)
+	{
+		const int found = tileItems[tile];
+		tileItems[tile] = offset;
+		offset += found;
+	}
+	items.resize(offset);
+	offsets[static_cast<size_t>(total) * types] = offset;
+}
+
+/**
+ * @brief Copy the neighbours of a tile of particles to their place in the flat lists
+ *
+ * @param tile tile of TILE_SIZE active particles
+ * @param total number of active particles
+ */
+void verletList::copyTile(const int tile, const int total)
+{
+	if (!rebuild) return;
+	const int first = tileItems[tile];
+	const size_t end = static_cast<size_t>(std::min(total, (tile + 1) * TILE_SIZE)) * types;
+	for (auto row = static_cast<size_t>(tile) * TILE_SIZE * types; row < end; row++) offsets[row] += first;
+	const int last = tile + 1 < static_cast<int>(tileItems.size()) ? tileItems[tile + 1] : static_cast<int>(items.size());
+	std::copy_n(tileLists[tile].begin(), last - first, items.begin() + first);
+}
+
+/**
+ * @brief Intensity of a shaped force at a share of its radius
+ *
+ * @param s distance / radius, from 0 to 1
+ * @param falloff exponent of the decay of the attraction
+ * @param core share of the radius with a repulsion
+ */
+static float profileIntensity(const float s, const float falloff, const float core)
+{
+	const float attraction = falloff > 0.0F ? std::pow(1.0F - s, falloff) : 1.0F;
+	const float repulsion = s < core ? 2.0F * (1.0F - s / core) : 0.0F;
+	return attraction - repulsion;
+}
+
+/**
+ * @brief Compile the plan again if the matrix or the non empty groups have changed
+ *
+ * @param matrix parameters of the pairs
+ * @param count number of active particles of each group
+ * @return true when the plan was compiled
+ */
+bool interactionPlan::update(const interactionMatrix& matrix, const int* count)
+{
+	const int types = matrix.types();
+	bool same = compiled && static_cast<int>(active.size()) == types;
+	for (auto t = 0; t < types && same; t++) same = active[t] == (count[t] > 0);
+	if (same && source == matrix) return false;
+
+	source = matrix;
+	active.resize(types);
+	for (auto t = 0; t < types; t++) active[t] = count[t] > 0;
+	compiled = true;
+	compiles++;
+
+	// a pair is drawn when it can pass its probability test, and its force computed when it is not 0
+	maxRadius = 0.0F;
+	drawn.assign(types, 0);
+	forced.assign(types, 0);
+	acting.assign(types, 0);
+	drawnTypes.assign(types, 0);
+	for (auto a = 0; a < types; a++)
+	{
+		for (auto b = 0; b < types; b++)
+		{
+			if (!active[a] || !active[b] || matrix.probability[a][b] <= 0.0F) continue;
+			drawn[a] |= groupMask(1) << b;
+			drawnTypes[a] = b + 1;
+			if (matrix.power[a][b] == 0.0F) continue;
+			acting[a] |= groupMask(1) << b;
+			if (matrix.radius[a][b] <= 0.0F) continue;
+			forced[a] |= groupMask(1) << b;
+			maxRadius = std::max(maxRadius, matrix.radius[a][b]);
+		}
+	}
+
+	// the samples of the constant force come first, then those of each shaped pair
+	profiles.assign(PROFILE_SAMPLES + 1, 1.0F);
+	profileOf.assign(static_cast<size_t>(types) * types, 0);
+	for (auto a = 0; a < types; a++)
+	{
+		for (auto b = 0; b < types; b++)
+		{
+			const float falloff = matrix.falloff[a][b];
+			const float core = matrix.core[a][b];
+			if (((forced[a] >> b) & 1) == 0 || (falloff <= 0.0F && core <= 0.0F)) continue;
+			profileOf[static_cast<size_t>(a) * types + b] = static_cast<int>(profiles.size());
+			for (auto k = 0; k <= PROFILE_SAMPLES; k++) profiles.push_back(profileIntensity(static_cast<float>(k) / PROFILE_SAMPLES, falloff, core));
+		}
+	}
+
+	// one traversal per unordered pair with a live direction, from the group of the live side
+	traversals.clear();
+	for (auto a = 0; a < types; a++)
+	{
+		for (auto b = a; b < types; b++)
+		{
+			const bool forward = (forced[a] >> b) & 1;
+			const bool reverse = (forced[b] >> a) & 1;
+			if (!forward && !reverse) continue;
+
+			traversal work;
+			work.cellGroup = forward ? a : b;
+			work.other = forward ? b : a;
+			work.radius2 = matrix.radius[work.cellGroup][work.other] * matrix.radius[work.cellGroup][work.other];
+			work.reverseRadius2 = forward && reverse ? matrix.radius[work.other][work.cellGroup] * matrix.radius[work.other][work.cellGroup] : 0.0F;
+			work.profile = profileOf[static_cast<size_t>(work.cellGroup) * types + work.other];
+			work.reverseProfile = work.reverseRadius2 > 0.0F ? profileOf[static_cast<size_t>(work.other) * types + work.cellGroup] : 0;
+			work.shaped = work.profile > 0 || work.reverseProfile > 0;
+			traversals.push_back(work);
+		}
+	}
+	std::stable_sort(traversals.begin(), traversals.end(), [](const traversal& l, const traversal& r) { return l.other < r.other; });
+	return true;
+}
+
+/**
+ * @brief Sum of the unit vectors pointing from the points of a group to a position
+ *
+ * @param x position x
+ * @param y position y
+ * @param cells grid of the acting group, holding its frozen positions
+ * @param radius radius of interaction
+ * @param infinite ignore the radius and scan the whole group
+ * @param fx sum on x
+ * @param fy sum on y
+ */
+static inline void accumulateForce(const float x, const float y, const grid& cells, const float radius, const bool infinite, float& fx, float& fy)
+{
+	const int n = static_cast<int>(cells.cellItems.size());
+	if (infinite)
+	{
+		forceSpan(x, y, cells.px.data(), cells.py.data(), 0, n, std::numeric_limits<float>::infinity(), fx, fy);
+		return;
+	}
+
+	const float radius2 = radius * radius;
+	const int cx = cells.cellX(x);
+	const int cy = cells.cellY(y);
+	for (auto row = cy - 1; row <= cy + 1; row++)
+	{
+		// neighbouring cells of the same row are stored contiguously
+		const int begin = cells.cellStart[cells.cell(cx - 1, row)];
+		const int end = cells.cellStart[cells.cell(cx + 1, row) + 1];
+		forceSpan(x, y, cells.px.data(), cells.py.data(), begin, end, radius2, fx, fy);
+	}
+}
+
+/**
+ * @brief Forces between the points of one cell of a group and the neighbouring points of another group
+ *
+ * Each unordered pair of points in range is evaluated once, with a single distance: the force on the
+ * point of the cell is summed in place and, when the traversal computes both directions, the opposite
+ * force of the pair is added to the neighbour. Against itself the group only looks at the points after
+ * the current one in the cell, the next cell of the row and the three cells of the next row; the other
+ * groups are looked up in the whole 3x3 block.
+ * All the writes stay in the 3x3 block of cells around the cell. The forces on the ghosts of a periodic
+ * grid are added to their particles afterwards.
+ *
+ * @param work the pair of groups and their radii
+ * @param cx cell column
+ * @param cy cell row
+ */
+void simulation::cellPairs(const interactionPlan::traversal& work, const int cx, const int cy)
+{
+	const int a = work.cellGroup;
+	const int b = work.other;
+	grid& own = subdiv[a];
+	grid& other = subdiv[b];
+	const int cell = own.cell(cx, cy);
+	const groupMask bit = groupMask(1) << a;
+	float* rx = other.fx.data() + static_cast<size_t>(a) * other.stride();
+	float* ry = other.fy.data() + static_cast<size_t>(a) * other.stride();
+	float* ownX = own.fx.data() + static_cast<size_t>(b) * own.stride();
+	float* ownY = own.fy.data() + static_cast<size_t>(b) * own.stride();
+
+	// both directions over a span of the other group, through the profile kernel when one of them is shaped
+	const float radius = std::sqrt(work.radius2);
+	const float reverseRadius = std::sqrt(work.reverseRadius2);
+	const float* profile = plan.profiles.data() + work.profile;
+	const float* reverseProfile = plan.profiles.data() + work.reverseProfile;
+	auto span = [&](const float x, const float y, const bool gated, const int begin, const int end, float& fx, float& fy)
+	{
+		if (work.shaped)
+		{
+			profileSpan(x, y, other.px.data(), other.py.data(), other.gates.data(), begin, end,
+				gated ? radius : 0.0F, profile, reverseRadius, reverseProfile, bit, rx, ry, fx, fy);
+		}
+		else
+		{
+			pairSpan(x, y, other.px.data(), other.py.data(), other.gates.data(), begin, end,
+				gated ? work.radius2 : 0.0F, work.reverseRadius2, bit, rx, ry, fx, fy);
+		}
+	};
+
+	for (auto s = own.cellStart[cell]; s < own.cellStart[cell + 1]; s++)
+	{
+		const float x = own.px[s];
+		const float y = own.py[s];
+		const bool gated = (own.gates[s] >> b) & 1;
+		float fx = 0;
+		float fy = 0;
+		if (b == a)
+		{
+			span(x, y, gated, s + 1, other.cellStart[other.cell(cx + 1, cy) + 1], fx, fy);
+			span(x, y, gated, other.cellStart[other.cell(cx - 1, cy + 1)], other.cellStart[other.cell(cx + 1, cy + 1) + 1], fx, fy);
+		}
+		else if (work.reverseRadius2 > 0.0F || (gated && work.shaped))
+		{
+			// a shaped force one way only goes through the profile kernel too, with a reverse radius of 0
+			for (auto row = cy - 1; row <= cy + 1; row++)
+			{
+				span(x, y, gated, other.cellStart[other.cell(cx - 1, row)], other.cellStart[other.cell(cx + 1, row) + 1], fx, fy);
+			}
+		}
+		else if (gated)
+		{
+			// one way only, nothing is written to the other group
+			for (auto row = cy - 1; row <= cy + 1; row++)
+			{
+				forceSpan(x, y, other.px.data(), other.py.data(),
+					other.cellStart[other.cell(cx - 1, row)], other.cellStart[other.cell(cx + 1, row) + 1], work.radius2, fx, fy);
+			}
+		}
+		ownX[s] += fx;
+		ownY[s] += fy;
+	}
+}
+
+/**
+ * @brief Remove the lowest group of a mask
+ *
+ * @param mask groups left, the returned one is cleared
+ * @return the group, -1 when the mask is empty
+ */
+static inline int popGroup(groupMask& mask)
+{
+	if (mask == 0) return -1;
+#if defined(_MSC_VER)
+	unsigned long b;
+	_BitScanForward(&b, mask);
+#else
+	const int b = __builtin_ctz(mask);
+#endif
+	mask &= mask - 1;
+	return static_cast<int>(b);
+}
+
+/**
+ * @brief Forces on a tile of particles, from the quadtrees or from the Verlet lists
+ *
+ * The forces known to be 0 are left at 0.
+ *
+ * @tparam Infinite infinite radius, through the quadtrees
+ */
+template <bool Infinite>
+void simulation::forceTile(const int tile, const int* start, const simulationParams& params)
+{
+	const int types = particles.types();
+	// the forces of the lists only reach across the borders on a periodic canvas
+	const bool periodic = params.bounded && params.periodic;
+	const float width = periodic ? neighbours.width : 0.0F;
+	const float height = periodic ? neighbours.height : 0.0F;
+	for (auto k = tile * TILE_SIZE; k < std::min(start[types], (tile + 1) * TILE_SIZE); k++)
+	{
+		const int a = groupOf(start, k);
+		grid& cells = subdiv[a];
+		const int i = k - start[a];
+		const int slot = cells.slots[i];
+		const float x = cells.px[slot];
+		const float y = cells.py[slot];
+		groupMask computed = cells.gates[slot] & (Infinite ? plan.acting[a] : plan.forced[a]);
+		for (auto b = popGroup(computed); b >= 0; b = popGroup(computed))
+		{
+			float fx = 0;
+			float fy = 0;
+			if (Infinite)
+			{
+				trees[b].force(x, y, params.openingAngle, forceSpan, fx, fy);
+			}
+			else
+			{
+				const size_t row = static_cast<size_t>(k) * types + b;
+				const int first = neighbours.offsets[row];
+				neighbourSpan(x, y, particles.x.data() + particles.start[b], particles.y.data() + particles.start[b], neighbours.items.data() + first,
+					neighbours.offsets[row + 1] - first, params.matrix.radius[a][b], plan.profile(a, b), width, height, fx, fy);
+			}
+			cells.fx[static_cast<size_t>(b) * cells.stride() + slot] = fx;
+			cells.fy[static_cast<size_t>(b) * cells.stride() + slot] = fy;
+		}
+	}
+}
+
+/**
+ * @brief Velocities and positions of a tile of particles, each particle only writes itself
+ *
+ * The acting groups of each particle are gone through itself first and then the others in slider order,
+ * straight from the bits of its gate.
+ * The options are template parameters, so that each variant has no test left in its loop.
+ *
+ * @tparam Repel the walls push the particles back
+ * @tparam Bounded positions wrap around the canvas
+ * @tparam Gravity world gravity is not 0
+ * @tparam Mesh mass gravity is on, its field is read from the mesh at the position of the frame, and is
+ * kept for the interface
+ */
+template <bool Repel, bool Bounded, bool Gravity, bool Mesh>
+void simulation::integrateTile(const int tile, const int* start, const simulationParams& params)
+{
+	const interactionMatrix& matrix = params.matrix;
+	const float gravity = params.gravity;
+	const float repel = params.wallRepel;
+	const float width = static_cast<float>(params.width);
+	const float height = static_cast<float>(params.height);
+
+	for (auto k = tile * TILE_SIZE; k < std::min(start[particles.types()], (tile + 1) * TILE_SIZE); k++)
+	{
+		const int a = groupOf(start, k);
+		const int i = k - start[a];
+		const int p = particles.start[a] + i;
+		const grid& cells = subdiv[a];
+		const int slot = cells.slots[i];
+
+		float x = particles.x[p];
+		float y = particles.y[p];
+		float vx = particles.vx[p];
+		float vy = particles.vy[p];
+
+		// mass gravity, once per step, the acting groups then damp it with the rest of the velocity
+		if (Mesh)
+		{
+			const particleMesh::sample s = mesh.interpolate(x, y);
+			field[p] = s;
+			vx += s.gx;
+			vy += s.gy;
+		}
+
+		// the group itself first, then the other ones
+		const groupMask self = groupMask(1) << a;
+		groupMask others = cells.gates[slot] & ~self;
+		for (auto b = cells.gates[slot] & self ? a : popGroup(others); b >= 0; b = popGroup(others))
+		{
+			const float fx = cells.fx[static_cast<size_t>(b) * cells.stride() + slot];
+			const float fy = cells.fy[static_cast<size_t>(b) * cells.stride() + slot];
+
+			//Calculate new velocity
+			const float g = matrix.power[a][b] / -100;	//Gravity coefficient
+			const float viscosity = matrix.viscosity[a][b];
+			vx = (vx + (fx * g)) * (1 - viscosity);
+			vy = (vy + (fy * g)) * (1 - viscosity);
+			if (Gravity) vy += gravity;
+
+			// Wall Repel
+			if (Repel)
+			{
+				if (x < repel) vx += (repel - x) * 0.1;
+				if (y < repel) vy += (repel - y) * 0.1;
+				if (x > width - repel) vx += (width - repel - x) * 0.1;
+				if (y > height - repel) vy += (height - repel - y) * 0.1;
+			}
+
+			//Checking for canvas bounds
+			if (Bounded)
+			{
+				if (x < 0)
+				{
+					x += width;
+				}
+				else if (x > width)
+				{
+					x -= width;
+				}
+
+				if (y < 0)
+				{
+					y += height;
+				}
+				else if (y > height)
+				{
+					y -= height;
+				}
+			}
+			//Update position based on velocity
+			x += vx;
+			y += vy;
+		}
+
+		particles.x[p] = x;
+		particles.y[p] = y;
+		particles.vx[p] = vx;
+		particles.vy[p] = vy;
+	}
+}
+
+/**
+ * @brief Interaction of every group with every group, in a single pass over the particles
+ *
+ * The step has two phases. The force phase only reads the positions frozen in the grids at the start of
+ * the frame and stores the force of every acting group on every particle: each pair of points is visited
+ * once, in nine passes over cells three apart so that no two threads write near each other, and gives
+ * the forces in both directions. The integration phase then
+ * goes through the acting groups of each particle, itself first and then the others in slider order
+ * (the order of the former per pair calls), and updates velocity and position. No thread ever reads a
+ * position that is being written, so the result does not depend on the number of threads.
+ * The whole step is given to the thread pool at once, as a chain of stages split into tiles.
+ * The parameters of each pair are read from the interaction matrix.
+ * With an infinite radius the forces come from the Barnes-Hut quadtree of each group, and with the Verlet
+ * lists on from the neighbours listed for each particle.
+ * The mass gravity of all the groups comes from the particle mesh, whose stages run before the force phase.
+ * The force and integration kernels are compiled for each combination of the options and picked once
+ * per step from a table, so that their loops do not test the options.
+ * The number of groups is only known at run time: the particles of all the groups are a single sorted
+ * buffer, the parameters dense tables, and the pairs that interact come from the plan.
+ * The step only reads the parameters it is given, it never looks at the interface.
+ *
+ * @param params interaction matrix, canvas and options of this step
+ */
+void simulation::step(const simulationParams& params)
+{
+	const bool radius_toggle = params.infinite;
+	const bool bounds_toggle = params.bounded;
+	const interactionMatrix& matrix = params.matrix;
+	const int types = particles.types();
+	if (matrix.types() != types || static_cast<int>(params.active.size()) != types || static_cast<int>(params.mass.size()) != types) return;
+
+	// all the active particles of all the groups are split into tiles as a single range
+	std::vector<int> count(types);
+	std::vector<int> start(types + 1, 0);
+	std::vector<int> gateTiles(types + 1, 0);
+	for (auto t = 0; t < types; t++)
+	{
+		count[t] = params.active[t] ? particles.count(t) : 0;
+		start[t + 1] = start[t] + count[t];
+		gateTiles[t + 1] = gateTiles[t] + (count[t] + GATE_CHUNK - 1) / GATE_CHUNK;
+	}
+	plan.update(matrix, count.data());
+
+	// the grid cells must cover the largest radius of the forces that are computed,
+	// and the Verlet lists look further, by the skin
+	const bool verlet_toggle = params.verlet && !radius_toggle;
+	const float skin = verlet_toggle ? neighbours.nextSkin(params.skin, plan.maxRadius) : 0.0F;
+	const float maxRadius = plan.maxRadius + skin;
+
+	// on a wrapped canvas the forces can reach across the borders too,
+	// and the Verlet lists follow the particles across them whether the forces do or not
+	const bool wrap = bounds_toggle && params.periodic && !radius_toggle;
+	for (auto& cells : subdiv) cells.setup(maxRadius, params.width, params.height, wrap || (verlet_toggle && bounds_toggle));
+
+	for (auto t = 0; t < types; t++)
+	{
+		if (count[t] == 0) continue;
+		const float* x = particles.x.data() + particles.start[t];
+		const float* y = particles.y.data() + particles.start[t];
+		subdiv[t].build(x, y, count[t], types);
+
+		// the buffers are sorted again when too many particles are far from the previous one
+		if (subdiv[t].scattered > REORDER_THRESHOLD * count[t])
+		{
+			reorder(pool, particles, particles.start[t], count[t], subdiv[t]);
+			subdiv[t].build(x, y, count[t], types);
+			neighbours.valid = false;
+		}
+	}
+	const int total = start[types];
+	const int particleTiles = (total + TILE_SIZE - 1) / TILE_SIZE;
+
+	// the Verlet lists are only rebuilt when a particle may have come in range of a new one
+	const bool restructure = verlet_toggle && neighbours.changed(count.data(), plan.forced.data(), matrix, params.skin, subdiv[0].periodic);
+	if (verlet_toggle) neighbours.tileMoved.resize(particleTiles);
+	const bool checkTree = radius_toggle && total > 0 && frame % TREE_ERROR_PERIOD == 0;
+
+	// the mesh has a power of 2 of cells per side, it wraps around with the positions and the forces
+	const bool mesh_toggle = params.massGravity != 0.0F && total > 0;
+	if (mesh_toggle)
+	{
+		int cells = MESH_BLOCK;
+		while (cells < std::min(params.meshSize, MESH_MAX_SIZE)) cells *= 2;
+		mesh.setup(cells, params.width, params.height, bounds_toggle && params.periodic);
+		field.resize(particles.size());
+	}
+	double errors[TREE_ERROR_SAMPLES] = {};
+	double exacts[TREE_ERROR_SAMPLES] = {};
+
+	gates.resize(total);
+	const int cols = subdiv[0].cols;
+	const int rows = subdiv[0].rows;
+
+	// the kernels of the stages are chosen once per step, from the options
+	static const tileKernel forceKernels[2] = { &simulation::forceTile<false>, &simulation::forceTile<true> };
+	static const tileKernel integrateKernels[16] = {
+		&simulation::integrateTile<false, false, false, false>, &simulation::integrateTile<true, false, false, false>,
+		&simulation::integrateTile<false, true, false, false>, &simulation::integrateTile<true, true, false, false>,
+		&simulation::integrateTile<false, false, true, false>, &simulation::integrateTile<true, false, true, false>,
+		&simulation::integrateTile<false, true, true, false>, &simulation::integrateTile<true, true, true, false>,
+		&simulation::integrateTile<false, false, false, true>, &simulation::integrateTile<true, false, false, true>,
+		&simulation::integrateTile<false, true, false, true>, &simulation::integrateTile<true, true, false, true>,
+		&simulation::integrateTile<false, false, true, true>, &simulation::integrateTile<true, false, true, true>,
+		&simulation::integrateTile<false, true, true, true>, &simulation::integrateTile<true, true, true, true>
+	};
+	const tileKernel forceKernel = forceKernels[radius_toggle ? 1 : 0];
+	const tileKernel integrateKernel = integrateKernels[(params.wallRepel > 0.0F ? 1 : 0) + (bounds_toggle ? 2 : 0) + (params.gravity != 0.0F ? 4 : 0) + (mesh_toggle ? 8 : 0)];
+
+	// the whole step is handed to the pool as a chain of stages
+	std::vector<threadPool::stage> stages;
+
+	// probability gates, drawn from (seed, frame, pair, particle) so they do not depend on the threads,
+	// with an infinite radius the quadtrees of the groups, and with the mass gravity the deposit of the masses
+	const int treeTiles = radius_toggle ? types : 0;
+	stages.push_back({ gateTiles[types] + treeTiles + (mesh_toggle ? MESH_COPIES : 0), [&](const int tile)
+	{
+		if (tile >= gateTiles[types] + treeTiles)
+		{
+			const int copy = tile - gateTiles[types] - treeTiles;
+			mesh.clear(copy);
+			const int last = static_cast<int>(static_cast<int64_t>(copy + 1) * total / MESH_COPIES);
+			for (auto k = static_cast<int>(static_cast<int64_t>(copy) * total / MESH_COPIES); k < last; k++)
+			{
+				const int a = groupOf(start.data(), k);
+				const int p = particles.start[a] + k - start[a];
+				if (params.mass[a] != 0.0F) mesh.deposit(copy, particles.x[p], particles.y[p], params.mass[a]);
+			}
+			return;
+		}
+		if (tile >= gateTiles[types])
+		{
+			const int t = tile - gateTiles[types];
+			if (count[t] > 0) trees[t].build(particles.x.data() + particles.start[t], particles.y.data() + particles.start[t], count[t]);
+			return;
+		}
+		auto a = 0;
+		while (tile >= gateTiles[a + 1]) a++;
+		const int first = (tile - gateTiles[a]) * GATE_CHUNK;
+		const int n = std::min(GATE_CHUNK, count[a] - first);
+		if (plan.drawn[a] == 0)
+		{
+			std::fill_n(&gates[start[a] + first], n, groupMask(0));
+			return;
+		}
+		// the groups after the last drawn one are not drawn at all, the draws of the others do not change
+		fillProbabilityMasks(seed, frame, a, plan.drawnTypes[a], matrix.probability[a], first, n, &gates[start[a] + first]);
+	} });
+
+	// the gates follow the points into the grids, then into the ghosts
+	stages.push_back({ particleTiles, [&](const int tile)
+	{
+		for (auto k = tile * TILE_SIZE; k < std::min(total, (tile + 1) * TILE_SIZE); k++)
+		{
+			const int a = groupOf(start.data(), k);
+			subdiv[a].gates[subdiv[a].slots[k - start[a]]] = gates[k] & plan.drawn[a];
+		}
+	} });
+	stages.push_back({ types, [&](const int a)
+	{
+		if (count[a] == 0) return;
+		grid& cells = subdiv[a];
+		for (const int ghost : cells.ghosts) cells.gates[ghost] = cells.gates[cells.slots[cells.cellItems[ghost]]];
+	} });
+
+	// mass gravity: the masses are summed, convolved with the kernel in Fourier space, and differentiated
+	if (mesh_toggle)
+	{
+		stages.push_back({ mesh.padded, [&](const int row) { mesh.gather(row); } });
+		stages.push_back({ mesh.size / MESH_BLOCK, [&](const int block) { mesh.forwardRows(block); } });
+		stages.push_back({ mesh.padded / MESH_BLOCK, [&](const int block) { mesh.convolveColumns(block); } });
+		stages.push_back({ mesh.inverseBlocks(), [&](const int block) { mesh.inverseRows(block); } });
+		stages.push_back({ mesh.size, [&](const int row) { mesh.differentiate(row, params.massGravity); } });
+	}
+
+	// Verlet lists: the displacements since the build, the decision, then the count and the fill of a build
+	if (verlet_toggle)
+	{
+		const groupMask* forced = plan.forced.data();
+		stages.push_back({ restructure ? 0 : particleTiles, [&](const int tile) { neighbours.measure(tile, particles, start.data()); } });
+		stages.push_back({ 1, [&, forced](int) { neighbours.decide(restructure, particleTiles, count.data(), forced, matrix, skin, subdiv[0]); } });
+		stages.push_back({ particleTiles, [&, forced](const int tile) { neighbours.searchTile(tile, subdiv.data(), start.data(), forced); } });
+		stages.push_back({ 1, [&](int) { neighbours.place(particleTiles, total); } });
+		stages.push_back({ particleTiles, [&](const int tile) { neighbours.copyTile(tile, total); } });
+	}
+
+	// force phase, positions are read only
+	if (radius_toggle || verlet_toggle)
+	{
+		stages.push_back({ particleTiles, [&](const int tile) { (this->*forceKernel)(tile, start.data(), params); } });
+	}
+	else
+	{
+		// one stage per color, one tile per cell
+		for (auto color = 0; color < 9; color++)
+		{
+			const int ox = color % 3;
+			const int oy = color / 3;
+			const int nx = (cols - ox + 2) / 3;
+			const int ny = (rows - oy + 2) / 3;
+			stages.push_back({ nx * ny, [&, ox, oy, nx](const int m)
+			{
+				for (const auto& work : plan.traversals) cellPairs(work, ox + 3 * (m % nx), oy + 3 * (m / nx));
+			} });
+		}
+
+		// the forces on the ghosts go back to their particles, one tile per pair so that nothing is shared
+		stages.push_back({ types * types, [&](const int pair)
+		{
+			grid& cells = subdiv[pair / types];
+			if (((plan.forced[pair / types] >> (pair % types)) & 1) == 0) return;
+			float* fx = cells.fx.data() + static_cast<size_t>(pair % types) * cells.stride();
+			float* fy = cells.fy.data() + static_cast<size_t>(pair % types) * cells.stride();
+			for (const int ghost : cells.ghosts)
+			{
+				const int slot = cells.slots[cells.cellItems[ghost]];
+				fx[slot] += fx[ghost];
+				fy[slot] += fy[ghost];
+			}
+		} });
+	}
+
+	// every now and then, compare the quadtree forces of a few particles with the exact ones
+	if (checkTree)
+	{
+		stages.push_back({ TREE_ERROR_SAMPLES, [&](const int sample)
+		{
+			const int k = static_cast<int>(static_cast<int64_t>(sample) * total / TREE_ERROR_SAMPLES);
+			const int a = groupOf(start.data(), k);
+			const grid& cells = subdiv[a];
+			const int slot = cells.slots[k - start[a]];
+			groupMask computed = cells.gates[slot] & plan.acting[a];
+			for (auto b = popGroup(computed); b >= 0; b = popGroup(computed))
+			{
+				float ex = 0;
+				float ey = 0;
+				accumulateForce(cells.px[slot], cells.py[slot], subdiv[b], 0.0F, true, ex, ey);
+				const size_t index = static_cast<size_t>(b) * cells.stride() + slot;
+				errors[sample] += std::hypot(cells.fx[index] - ex, cells.fy[index] - ey);
+				exacts[sample] += std::hypot(ex, ey);
+			}
+		} });
+	}
+
+	// integration phase, each particle only writes itself
+	stages.push_back({ particleTiles, [&](const int tile) { (this->*integrateKernel)(tile, start.data(), params); } });
+
+	pool.run(stages);
+
+	if (checkTree)
+	{
+		double errorSum = 0.0;
+		double exactSum = 0.0;
+		for (auto sample = 0; sample < TREE_ERROR_SAMPLES; sample++)
+		{
+			errorSum += errors[sample];
+			exactSum += exacts[sample];
+		}
+		if (exactSum > 0.0) treeError = static_cast<float>(100.0 * errorSum / exactSum);
+	}
+	frame++;
+}
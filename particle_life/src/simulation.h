@@ -0,0 +1,377 @@
+#pragma once
+
+#include "particleMesh.h"
+#include "quadTree.h"
+#include "threadPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Particle life engine: particle groups, interaction matrix and simulation step.
+ * Nothing here depends on openFrameworks or on a window, the interface and the headless runner both
+ * drive the same engine.
+ */
+
+#define GRID_MAX_CELLS 65536 // upper bound on the number of cells of the neighbour grid
+#define TYPE_COUNT 8 // number of particle groups of the interface and of the model files (alpha to teta)
+#define TYPE_MAX 32 // largest number of particle groups of the engine, one bit of a groupMask each
+#define GATE_CHUNK 1024 // particles per probability gate task
+#define TILE_SIZE 256 // particles per task of the other stages of the step
+#define TREE_ERROR_PERIOD 60 // frames between two checks of the quadtree against the exact force
+#define TREE_ERROR_SAMPLES 32 // particles used by a check
+#define REORDER_THRESHOLD 0.25F // share of consecutive particles in distant cells that triggers a spatial sort of a group
+
+/*
+ * for collision detection :
+ * if (distance(x center, x line) < radius) then intersect 
+ */
+
+// one bit per group, for the probability gates and the pairs of the plan
+typedef uint32_t groupMask;
+
+/*
+ * Color of a group, 8 bits per channel.
+ */
+struct particleColor
+{
+	unsigned char r = 0;
+	unsigned char g = 0;
+	unsigned char b = 0;
+};
+
+/*
+ * The particles of every group in a single buffer, sorted by group: group t is the range
+ * [start[t], start[t + 1]) and all its particles share the color of the group.
+ * Positions and velocities are kept in separate arrays (structure of arrays), so the force loop only
+ * streams the coordinates it reads and the color is stored once for the whole group.
+ */
+struct particleBuffer
+{
+	//Position
+	std::vector<float> x;
+	std::vector<float> y;
+
+	//Velocity
+	std::vector<float> vx;
+	std::vector<float> vy;
+
+	//Creation index of each particle in its group, it follows the particle when the buffers are reordered
+	std::vector<int> id;
+
+	std::vector<int> start = { 0 };		// first particle of each group, types() + 1 entries
+
+	//Color of each group
+	std::vector<particleColor> color;
+
+	int types() const { return static_cast<int>(color.size()); }
+	int count(const int t) const { return start[t + 1] - start[t]; }
+	size_t size() const { return x.size(); }
+};
+
+/*
+ * Uniform cell list used for the neighbour search.
+ * The cells tile the canvas and are never smaller than the largest active radius, so every point closer
+ * than the radius to a given position lies in the 3x3 block of cells around that position.
+ * The cells are framed by a ring of halo cells, so that the 3x3 block of a border cell exists too.
+ * The halo is empty, unless the grid is periodic: it then holds ghost copies of the points of the
+ * opposite border, shifted by the canvas size, and the 3x3 block gives the wrapped neighbours.
+ * The grid keeps its own copy of the positions, sorted by cell: it is the frozen buffer read by
+ * the force phase while the integration phase writes the new positions into the groups.
+ * The probability gates and the forces on the points are kept in the same sorted order.
+ */
+struct grid
+{
+	float cellWidth = 1.0F;
+	float cellHeight = 1.0F;
+	int cols = 1;
+	int rows = 1;
+	float width = 1.0F;
+	float height = 1.0F;
+	bool periodic = false;
+	std::vector<int> cellStart = { 0, 0 };	// index of the first item of each cell, halo included, (cols + 2) * (rows + 2) + 1 entries
+	std::vector<int> cellItems;				// point indices sorted by cell, ghosts included
+	std::vector<int> slots;					// sorted index of each point (inverse of cellItems without the ghosts)
+	std::vector<int> ghosts;				// sorted indices of the ghosts
+	std::vector<float> px;					// positions sorted by cell
+	std::vector<float> py;
+	std::vector<groupMask> gates;			// probability gates of the sorted points
+	std::vector<float> fx;					// force of each acting group on the sorted points, fx[group * stride() + slot]
+	std::vector<float> fy;
+	int scattered = 0;						// consecutive points of the group buffer that are not in neighbouring cells
+
+	void setup(float radius, int canvasWidth, int canvasHeight, bool wrap);
+	void build(const float* x, const float* y, int n, int types);
+
+	// length of a padded buffer
+	int stride() const { return static_cast<int>(px.size()); }
+
+	// index of a cell, from -1 to cols and from -1 to rows with the halo
+	int cell(const int cx, const int cy) const { return (cy + 1) * (cols + 2) + cx + 1; }
+
+	// positions outside of the canvas are clamped to the border cells
+	int cellX(const float x) const { return std::min(std::max(static_cast<int>(x / cellWidth), 0), cols - 1); }
+	int cellY(const float y) const { return std::min(std::max(static_cast<int>(y / cellHeight), 0), rows - 1); }
+};
+
+/*
+ * One parameter of every pair of groups, as a dense row major square: table[a][b] is the value of the
+ * pair (a, b).
+ */
+struct pairTable
+{
+	int types = 0;
+	std::vector<float> values;
+
+	void resize(int n);
+
+	float* operator[](const int a) { return values.data() + static_cast<size_t>(a) * types; }
+	const float* operator[](const int a) const { return values.data() + static_cast<size_t>(a) * types; }
+	bool operator==(const pairTable& other) const { return types == other.types && values == other.values; }
+};
+
+/*
+ * Dense parameters of every pair of groups, for any number of groups.
+ * The first index is the group that is moved, the second one the group acting on it.
+ * The force of a pair is constant over its radius, unless its falloff or its core shape it (see
+ * interactionPlan).
+ */
+struct interactionMatrix
+{
+	pairTable power;
+	pairTable radius;
+	pairTable viscosity;
+	pairTable probability;
+	pairTable falloff;		// exponent of the decay of the attraction over the radius, 0 for a constant force
+	pairTable core;			// share of the radius where a repulsion grows towards the center, 0 for none
+
+	explicit interactionMatrix(const int types = TYPE_COUNT) { resize(types); }
+
+	int types() const { return power.types; }
+
+	// the pairs of the groups kept keep their parameters, the new ones start at 0
+	void resize(int n);
+
+	bool operator==(const interactionMatrix& other) const
+	{
+		return power == other.power && radius == other.radius && viscosity == other.viscosity && probability == other.probability &&
+			falloff == other.falloff && core == other.core;
+	}
+};
+
+/*
+ * Verlet neighbour lists.
+ * For every pair of groups, each particle lists the particles of the acting group closer than the radius
+ * of the pair plus a skin margin. As long as no particle has moved by more than half of the skin, every
+ * point in range is still in the lists, and the neighbour search can be skipped.
+ * The lists of all the pairs are flat: row k * types + b holds the neighbours in group b of the active
+ * particle k, all the groups being one range like the tiles of the step, from offsets[row] to
+ * offsets[row + 1] in items. They are built on the thread pool of the step in a single search over the
+ * tiles of particles, each tile listing its rows in its own buffer, then copied after the tiles before it.
+ * When the positions wrap around the canvas, distances and displacements are taken to the nearest image,
+ * so a particle that crosses a border keeps its neighbours; the forces only wrap on a periodic canvas.
+ * With a skin of 0 the skin follows the particles: a larger skin lengthens the lists but makes the builds
+ * rarer, a build being needed about every skin / (2 * speed) steps for the largest displacement per step.
+ * Each build takes the skin that minimizes (radius + skin)^2 * (1 + 2 * VERLET_BUILD_COST * speed / skin),
+ * the cost of a step with the builds spread over it.
+ */
+
+#define VERLET_BUILD_COST 4.0F // cost of a build over the cost of the forces of a step, measured on the bundled models
+#define VERLET_MIN_SKIN 1.0F // smallest automatic skin
+
+struct verletList
+{
+	int types = 0;
+	std::vector<int> offsets;		// first neighbour of each row, active particles * types + 1 entries
+	std::vector<int> items;			// neighbours, indices in the acting group
+	std::vector<int> tileItems;		// neighbours found by each tile, then the first of its items
+	std::vector<std::vector<int>> tileLists;	// neighbours found by each tile, before they are placed
+	std::vector<float> tileMoved;	// largest squared displacement in each tile since the build
+	std::vector<int> refCount;		// active particles of each group when the lists were built
+	std::vector<float> refX;		// their positions, in the order of the tiles
+	std::vector<float> refY;
+	pairTable cutoff;				// listed radius of each pair, 0 for a pair without lists
+	float skin = 0.0F;				// skin of the lists
+	float speed = 0.0F;				// largest displacement of a particle in a step, measured since the build
+	float width = 0.0F;				// canvas size, for the nearest images
+	float height = 0.0F;
+	bool wrapped = false;			// built for positions that wrap around the canvas
+	int age = 0;					// steps since the build
+	int builds = 0;					// number of builds since the start
+	bool valid = false;				// false when the particles were moved in their buffers
+	bool rebuild = false;			// the lists are built again by the current step
+
+	// skin of the next build, the one wanted or the one that balances the builds and the forces
+	float nextSkin(const float margin, const float radius) const
+	{
+		if (margin > 0.0F) return margin;
+		const float cv = VERLET_BUILD_COST * speed;
+		return std::max(VERLET_MIN_SKIN, 0.5F * (std::sqrt(cv * cv + 4.0F * cv * radius) - cv));
+	}
+
+	bool changed(const int* count, const groupMask* forced, const interactionMatrix& matrix, float margin, bool wrap) const;
+	void measure(int tile, const particleBuffer& particles, const int* start);
+	void decide(bool structure, int tiles, const int* count, const groupMask* forced, const interactionMatrix& matrix, float margin, const grid& cells);
+	void searchTile(int tile, const grid* cells, const int* start, const groupMask* forced);
+	void place(int tiles, int total);
+	void copyTile(int tile, int total);
+
+private:
+	void search(int k, int a, int i, int b, const grid& other, std::vector<int>& list, int& n) const;
+};
+
+/*
+ * Execution plan of the step, compiled from the interaction matrix and the non empty groups.
+ * A pair is dead when one of its groups is empty or when its probability is 0: it is never drawn, searched
+ * or integrated. A pair with a power or a radius of 0 is still drawn and integrated, its gate moves the
+ * particle, but its force is known to be 0 and is not computed.
+ * The two directions of a pair of groups are searched together: a single traversal of the neighbours
+ * gives the forces of both, each with its own radius, and a pair with one live direction is searched one
+ * way from that side. The traversals are sorted by searched group, so that the block of cells of a group
+ * stays in cache from one traversal to the next.
+ * The pairs with a shaped force get their profile sampled over [0, radius], the kernels read the samples
+ * instead of evaluating the force law. At a distance s * radius the intensity is
+ * (1 - s)^falloff - 2 * (1 - s / core) inside the core and (1 - s)^falloff outside, so a falloff and a core
+ * of 0 give the constant force, which keeps the plain kernels.
+ * The plan is only compiled again when its inputs change, that is when a slider moves.
+ */
+struct interactionPlan
+{
+	struct traversal
+	{
+		int cellGroup;			// group whose cells are visited
+		int other;				// group searched in the 3x3 block around the cell
+		float radius2;			// squared radius of the force of other on cellGroup, 0 when it is not computed
+		float reverseRadius2;	// squared radius of the force of cellGroup on other, 0 when it is not computed
+		int profile;			// offsets of the profiles of the two directions in profiles, 0 for the constant one
+		int reverseProfile;
+		bool shaped;			// one of the directions has a profile
+	};
+
+	std::vector<groupMask> drawn;			// groups whose gate is drawn for each group
+	std::vector<groupMask> forced;			// groups whose force on each group is computed
+	std::vector<groupMask> acting;			// the same with an infinite radius, where only the power matters
+	std::vector<int> drawnTypes;			// number of groups covered by the draws of each group, the last drawn one + 1
+	std::vector<traversal> traversals;		// in locality order
+	std::vector<float> profiles;			// PROFILE_SAMPLES + 1 samples per shaped pair, after those of the constant force
+	std::vector<int> profileOf;				// offset of the profile of each pair a * types + b, 0 for a constant force
+	float maxRadius = 0.0F;					// largest radius of a computed force
+	int compiles = 0;						// number of compilations since the start
+
+	bool update(const interactionMatrix& matrix, const int* count);
+
+	// samples of the force of b on a, null for a constant force
+	const float* profile(const int a, const int b) const
+	{
+		const int offset = profileOf[static_cast<size_t>(a) * drawn.size() + b];
+		return offset > 0 ? profiles.data() + offset : nullptr;
+	}
+
+private:
+	interactionMatrix source;				// inputs of the last compilation
+	std::vector<bool> active;
+	bool compiled = false;
+};
+
+/*
+ * Everything a simulation step reads from the interface, copied from the sliders by update()
+ * or from the command line by the headless runner.
+ */
+struct simulationParams
+{
+	interactionMatrix matrix;		// as many groups as the particles of the simulation
+	std::vector<bool> active = std::vector<bool>(TYPE_COUNT);	// groups whose count is not 0
+	int width = 1;					// canvas size
+	int height = 1;
+	bool infinite = false;			// infinite radius, through the quadtrees
+	bool bounded = true;			// positions wrap around the canvas
+	bool periodic = false;			// forces wrap around the canvas too
+	bool verlet = false;			// Verlet lists instead of the grid
+	float skin = 0.0F;				// margin of the Verlet lists, 0 for one that follows the speed of the particles
+	float openingAngle = 0.5F;
+	float gravity = 0.0F;
+	float wallRepel = 20.0F;
+	float massGravity = 0.0F;		// constant of the mass gravity, through the particle mesh, 0 for none
+	int meshSize = 128;				// cells per side of the particle mesh, rounded up to a power of 2
+	std::vector<float> mass = std::vector<float>(TYPE_COUNT, 1.0F);	// mass of the particles of each group, negative for antigravity
+
+	// number of groups of the matrix, of the active flags and of the masses
+	void resize(const int types)
+	{
+		matrix.resize(types);
+		active.resize(types, false);
+		mass.resize(types, 1.0F);
+	}
+};
+
+/*
+ * The simulation engine, without any window: the particle groups and the step that moves them.
+ * An instance owns its particles, its spatial structures and its worker threads, so that several of them
+ * can run side by side in the same process.
+ */
+class simulation
+{
+public:
+	/**
+	 * @param threads number of threads of the step, 0 for one per core
+	 */
+	explicit simulation(int threads = 0);
+
+	/**
+	 * @brief Scatter new particles on the canvas
+	 *
+	 * Every group with a count above 0 gets that many particles at random positions, at rest, with a random
+	 * color. The other groups are left as they are, or empty when they are new. The positions, the colors and
+	 * the probability draws of the following steps all come from the seed.
+	 *
+	 * @param count number of particles of each group
+	 * @param types number of groups, from 1 to TYPE_MAX
+	 * @param width canvas width
+	 * @param height canvas height
+	 * @param key seed of the run
+	 */
+	void restart(const int* count, int types, int width, int height, uint64_t key);
+
+	/**
+	 * @brief Move every particle by one step
+	 *
+	 * The matrix, the active flags and the masses of the parameters must have as many groups as the particles,
+	 * the step does nothing otherwise.
+	 */
+	void step(const simulationParams& params);
+
+	// number of groups of the particles
+	int types() const { return particles.types(); }
+
+	// number of threads working on a step
+	int threads() const { return pool.size(); }
+
+	// number of Verlet list builds since the start
+	int listBuilds() const { return neighbours.builds; }
+
+	// pairs of groups searched by the last step
+	int traversals() const { return static_cast<int>(plan.traversals.size()); }
+
+	particleBuffer particles;			// every group, alpha to teta first in the order of the sliders
+	uint64_t seed = 0;					// probability draws are keyed by the seed and counted by the frame number
+	uint32_t frame = 0;
+	float treeError = 0.0F;				// relative error of the last check of the quadtree, in percent
+	std::vector<particleMesh::sample> field;	// mass gravity and tidal tensor at each particle of the buffer, when the mass gravity is on
+
+private:
+	// kernel of a stage for one tile of particles, specialized for each combination of the step options
+	using tileKernel = void (simulation::*)(int tile, const int* start, const simulationParams& params);
+
+	void cellPairs(const interactionPlan::traversal& work, int cx, int cy);
+	template <bool Infinite> void forceTile(int tile, const int* start, const simulationParams& params);
+	template <bool Repel, bool Bounded, bool Gravity, bool Mesh> void integrateTile(int tile, const int* start, const simulationParams& params);
+
+	std::vector<grid> subdiv;			// subdivision grid of each group
+	std::vector<quadTree> trees;
+	particleMesh mesh;					// mass gravity of all the groups
+	verletList neighbours;
+	interactionPlan plan;
+	threadPool pool;					// workers of the step
+	std::vector<groupMask> gates;		// groups that passed the probability test, for each particle
+};
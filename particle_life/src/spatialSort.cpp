@@ -0,0 +1,93 @@
+#include "spatialSort.h"
+
+#include <algorithm>
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_TILE 16384 // keys counted and scattered by a tile of a pass
+
+// spreads the 16 low bits of v over the even bits
+static uint32_t spreadBits(uint32_t v)
+{
+	v &= 0x0000FFFFu;
+	v = (v | (v << 8)) & 0x00FF00FFu;
+	v = (v | (v << 4)) & 0x0F0F0F0Fu;
+	v = (v | (v << 2)) & 0x33333333u;
+	v = (v | (v << 1)) & 0x55555555u;
+	return v;
+}
+
+uint32_t mortonCode(const uint32_t x, const uint32_t y)
+{
+	return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+void radixSort(threadPool& pool, std::vector<uint32_t>& keys, std::vector<int>& values)
+{
+	const int n = static_cast<int>(keys.size());
+	if (n < 2) return;
+
+	uint32_t maxKey = 0;
+	for (const auto key : keys) maxKey = std::max(maxKey, key);
+	auto passes = 0;
+	while (passes * RADIX_BITS < 32 && (maxKey >> (passes * RADIX_BITS)) != 0) passes++;
+	if (passes == 0) return;
+
+	// the keys and the values go back and forth between the two buffers
+	std::vector<uint32_t> sortedKeys(n);
+	std::vector<int> sortedValues(n);
+	uint32_t* const keyBuffers[2] = { keys.data(), sortedKeys.data() };
+	int* const valueBuffers[2] = { values.data(), sortedValues.data() };
+	const int tiles = (n + RADIX_TILE - 1) / RADIX_TILE;
+	std::vector<int> histograms(static_cast<size_t>(tiles) * RADIX_SIZE);
+
+	std::vector<threadPool::stage> stages;
+	for (auto pass = 0; pass < passes; pass++)
+	{
+		const int shift = pass * RADIX_BITS;
+		const uint32_t* fromKeys = keyBuffers[pass & 1];
+		const int* fromValues = valueBuffers[pass & 1];
+		uint32_t* toKeys = keyBuffers[(pass + 1) & 1];
+		int* toValues = valueBuffers[(pass + 1) & 1];
+
+		stages.push_back({ tiles, [&, shift, fromKeys](const int tile)
+		{
+			int* histogram = histograms.data() + static_cast<size_t>(tile) * RADIX_SIZE;
+			std::fill_n(histogram, RADIX_SIZE, 0);
+			for (auto i = tile * RADIX_TILE; i < std::min(n, (tile + 1) * RADIX_TILE); i++) histogram[(fromKeys[i] >> shift) & (RADIX_SIZE - 1)]++;
+		} });
+
+		// offsets ordered by digit, then by tile, which keeps the sort stable
+		stages.push_back({ 1, [&](int)
+		{
+			int offset = 0;
+			for (auto digit = 0; digit < RADIX_SIZE; digit++)
+			{
+				for (auto t = 0; t < tiles; t++)
+				{
+					const int bucket = histograms[static_cast<size_t>(t) * RADIX_SIZE + digit];
+					histograms[static_cast<size_t>(t) * RADIX_SIZE + digit] = offset;
+					offset += bucket;
+				}
+			}
+		} });
+
+		stages.push_back({ tiles, [&, shift, fromKeys, fromValues, toKeys, toValues](const int tile)
+		{
+			int* histogram = histograms.data() + static_cast<size_t>(tile) * RADIX_SIZE;
+			for (auto i = tile * RADIX_TILE; i < std::min(n, (tile + 1) * RADIX_TILE); i++)
+			{
+				const int slot = histogram[(fromKeys[i] >> shift) & (RADIX_SIZE - 1)]++;
+				toKeys[slot] = fromKeys[i];
+				toValues[slot] = fromValues[i];
+			}
+		} });
+	}
+	pool.run(stages);
+
+	if (passes & 1)
+	{
+		keys.swap(sortedKeys);
+		values.swap(sortedValues);
+	}
+}
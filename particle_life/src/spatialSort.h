@@ -0,0 +1,33 @@
+#pragma once
+
+#include "threadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Spatial ordering of the particle buffers.
+ * Particles sorted along a Z-order (Morton) curve of their cells are close in memory when they are close
+ * on the canvas, so the neighbours read by the force loops share cache lines.
+ */
+
+/**
+ * @brief Morton code of a cell: the bits of x and y interleaved, x in the even bits
+ *
+ * @param x cell column (16 bits)
+ * @param y cell row (16 bits)
+ */
+uint32_t mortonCode(uint32_t x, uint32_t y);
+
+/**
+ * @brief Stable parallel radix sort of keys, carrying a value along with each key
+ *
+ * One 8 bit digit per pass, with one histogram per tile of RADIX_TILE keys; the passes above the largest
+ * key are skipped. All the passes are a single run of the pool: a histogram, a prefix and a scatter stage
+ * each.
+ *
+ * @param pool threads of the sort
+ * @param keys keys to sort
+ * @param values values moved with the keys, same size as keys
+ */
+void radixSort(threadPool& pool, std::vector<uint32_t>& keys, std::vector<int>& values);
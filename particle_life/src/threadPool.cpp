@@ -0,0 +1,131 @@
+#include "threadPool.h"
+
+#include <algorithm>
+
+threadPool::threadPool(int threads)
+{
+	if (threads <= 0) threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	for (auto index = 1; index < threads; index++) workers.emplace_back(&threadPool::loop, this, index);
+}
+
+threadPool::~threadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) worker.join();
+}
+
+void threadPool::run(const std::vector<stage>& stages)
+{
+	const int threads = size();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stages.size() > capacity)
+		{
+			capacity = stages.size();
+			ranges.reset(new std::atomic<uint64_t>[capacity * threads]);
+			completed.reset(new std::atomic<int>[capacity]);
+		}
+
+		// every thread starts with an even share of the tiles of each stage
+		for (size_t s = 0; s < stages.size(); s++)
+		{
+			const int64_t tiles = stages[s].tiles;
+			for (auto t = 0; t < threads; t++)
+			{
+				const uint64_t begin = static_cast<uint64_t>(tiles * t / threads);
+				const uint64_t end = static_cast<uint64_t>(tiles * (t + 1) / threads);
+				ranges[s * threads + t].store(begin << 32 | end, std::memory_order_relaxed);
+			}
+			completed[s].store(0, std::memory_order_relaxed);
+		}
+		current = &stages;
+		busy = static_cast<int>(workers.size());
+		generation++;
+	}
+	wake.notify_all();
+
+	execute(0);
+
+	// the stages belong to the caller, wait until no worker looks at them anymore
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this] { return busy == 0; });
+	current = nullptr;
+}
+
+void threadPool::loop(const int index)
+{
+	uint64_t seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping) return;
+			seen = generation;
+		}
+
+		execute(index);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--busy == 0) finished.notify_one();
+	}
+}
+
+void threadPool::execute(const int index)
+{
+	const std::vector<stage>& stages = *current;
+	const int threads = size();
+	for (size_t s = 0; s < stages.size(); s++)
+	{
+		const stage& step = stages[s];
+		std::atomic<uint64_t>* shares = &ranges[s * threads];
+		int done = 0;
+
+		// own tiles from the front, then the last tiles of the others
+		for (int tile; (tile = takeFront(shares[index])) >= 0; done++) step.work(tile);
+		for (auto stolen = true; stolen;)
+		{
+			stolen = false;
+			for (auto offset = 1; offset < threads; offset++)
+			{
+				for (int tile; (tile = takeBack(shares[(index + offset) % threads])) >= 0; done++)
+				{
+					step.work(tile);
+					stolen = true;
+				}
+			}
+		}
+
+		// the next stage may read anything this one wrote
+		if (done > 0) completed[s].fetch_add(done, std::memory_order_acq_rel);
+		while (completed[s].load(std::memory_order_acquire) < step.tiles) std::this_thread::yield();
+	}
+}
+
+int threadPool::takeFront(std::atomic<uint64_t>& range)
+{
+	uint64_t value = range.load(std::memory_order_relaxed);
+	while (true)
+	{
+		const uint64_t begin = value >> 32;
+		const uint64_t end = value & 0xFFFFFFFFu;
+		if (begin >= end) return -1;
+		if (range.compare_exchange_weak(value, (begin + 1) << 32 | end, std::memory_order_relaxed)) return static_cast<int>(begin);
+	}
+}
+
+int threadPool::takeBack(std::atomic<uint64_t>& range)
+{
+	uint64_t value = range.load(std::memory_order_relaxed);
+	while (true)
+	{
+		const uint64_t begin = value >> 32;
+		const uint64_t end = value & 0xFFFFFFFFu;
+		if (begin >= end) return -1;
+		if (range.compare_exchange_weak(value, begin << 32 | (end - 1), std::memory_order_relaxed)) return static_cast<int>(end - 1);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Persistent work stealing thread pool.
+ * The workers are started once and sleep between runs. A run is a chain of stages, each one split into
+ * tiles: a stage only starts when every tile of the previous one is done, so a whole simulation step is
+ * handed over at once instead of forking and joining for every loop.
+ * The tiles of a stage are first split evenly between the threads; a thread that runs out of tiles takes
+ * the last tiles of the others, so uneven tiles (small and large groups, crowded cells) keep every core busy.
+ */
+class threadPool
+{
+public:
+	struct stage
+	{
+		int tiles = 0;
+		std::function<void(int)> work;	// called once for every tile, from any thread
+	};
+
+	/**
+	 * @brief Start the workers
+	 *
+	 * @param threads number of threads including the caller of run(), 0 for one per core
+	 */
+	explicit threadPool(int threads = 0);
+	~threadPool();
+
+	threadPool(const threadPool&) = delete;
+	threadPool& operator=(const threadPool&) = delete;
+
+	/**
+	 * @brief Number of threads working on a run, the caller included
+	 */
+	int size() const { return static_cast<int>(workers.size()) + 1; }
+
+	/**
+	 * @brief Run the stages in order and return when the last one is done
+	 *
+	 * The calling thread works on the tiles too.
+	 */
+	void run(const std::vector<stage>& stages);
+
+private:
+	void loop(int index);
+	void execute(int index);
+	int takeFront(std::atomic<uint64_t>& range);
+	int takeBack(std::atomic<uint64_t>& range);
+
+	std::vector<std::thread> workers;
+	const std::vector<stage>* current = nullptr;
+	std::unique_ptr<std::atomic<uint64_t>[]> ranges;	// tiles left to each thread in each stage, begin << 32 | end
+	std::unique_ptr<std::atomic<int>[]> completed;		// tiles done in each stage
+	size_t capacity = 0;								// stages the buffers can hold
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	uint64_t generation = 0;	// number of runs started
+	int busy = 0;				// workers still in the current run
+	bool stopping = false;
+};
@@ -0,0 +1,186 @@
+#include "trailBuffer.h"
+#include "shaderProgram.h"
+
+#if defined(_WIN32)
+#include <GL/glew.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+#include <cmath>
+
+// corners of the viewport, and the matching texture coordinates
+static const char* vertexSource = R"(#version 120
+attribute vec2 corner;
+varying vec2 uv;
+void main()
+{
+	uv = corner * 0.5 + 0.5;
+	gl_Position = vec4(corner, 0.0, 1.0);
+}
+)";
+
+// previous frames scaled by the decay, then lowered by one step of 8 bits so that they reach black
+static const char* fadeSource = R"(#version 120
+uniform sampler2D source;
+uniform float decay;
+varying vec2 uv;
+void main()
+{
+	vec3 color = texture2D(source, uv).rgb;
+	gl_FragColor = vec4(max(color * decay - 1.0 / 255.0, 0.0), 1.0);
+}
+)";
+
+static const char* composeSource = R"(#version 120
+uniform sampler2D source;
+varying vec2 uv;
+void main()
+{
+	gl_FragColor = vec4(texture2D(source, uv).rgb, 1.0);
+}
+)";
+
+void trailBuffer::release()
+{
+	if (fadeProgram != 0) glDeleteProgram(fadeProgram);
+	if (composeProgram != 0) glDeleteProgram(composeProgram);
+	if (corners != 0) glDeleteBuffers(1, &corners);
+	if (framebuffers[0] != 0) glDeleteFramebuffers(2, framebuffers);
+	if (textures[0] != 0) glDeleteTextures(2, textures);
+	fadeProgram = composeProgram = corners = 0;
+	framebuffers[0] = framebuffers[1] = 0;
+	textures[0] = textures[1] = 0;
+	width = height = 0;
+}
+
+bool trailBuffer::setup()
+{
+	release();
+#if defined(_WIN32)
+	if (glGenFramebuffers == nullptr) return false;
+#endif
+	if (!hasOpenGL(3, 0) && !hasExtension("GL_ARB_framebuffer_object")) return false;
+	fadeProgram = linkProgram(vertexSource, fadeSource, { "corner" });
+	composeProgram = linkProgram(vertexSource, composeSource, { "corner" });
+	if (fadeProgram == 0 || composeProgram == 0)
+	{
+		release();
+		return false;
+	}
+	decayLocation = glGetUniformLocation(fadeProgram, "decay");
+	for (const GLuint program : { fadeProgram, composeProgram })
+	{
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "source"), 0);
+	}
+	glUseProgram(0);
+
+	const float quad[8] = { -1, -1, 1, -1, -1, 1, 1, 1 };
+	glGenBuffers(1, &corners);
+	glBindBuffer(GL_ARRAY_BUFFER, corners);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glGenTextures(2, textures);
+	glGenFramebuffers(2, framebuffers);
+	return true;
+}
+
+void trailBuffer::resize(const int canvasWidth, const int canvasHeight)
+{
+	GLint texture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+	for (auto i = 0; i < 2; i++)
+	{
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, canvasWidth, canvasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+		clear();
+	}
+	glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(texture));
+	width = canvasWidth;
+	height = canvasHeight;
+}
+
+void trailBuffer::clear()
+{
+	GLfloat color[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, color);
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glClearColor(color[0], color[1], color[2], color[3]);
+}
+
+void trailBuffer::quad(const unsigned int program, const unsigned int texture) const
+{
+	GLint bound = 0;
+	glActiveTexture(GL_TEXTURE0);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+	const GLboolean blending = glIsEnabled(GL_BLEND);
+	glDisable(GL_BLEND);
+	glUseProgram(program);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindBuffer(GL_ARRAY_BUFFER, corners);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+	glEnableVertexAttribArray(0);
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	// back to the state of the caller
+	glDisableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(bound));
+	glUseProgram(0);
+	if (blending) glEnable(GL_BLEND);
+}
+
+void trailBuffer::begin(const int canvasWidth, const int canvasHeight, const float decay)
+{
+	if (!ready() || canvasWidth <= 0 || canvasHeight <= 0) return;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &callerFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, callerViewport);
+	const bool cleared = canvasWidth != width || canvasHeight != height;
+	if (cleared) resize(canvasWidth, canvasHeight);
+
+	// the previous frames go to the other texture, faded, and the particles are drawn over them
+	const int target = 1 - current;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[target]);
+	glViewport(0, 0, width, height);
+	if (decay <= 0.0F)
+	{
+		if (!cleared) clear();
+	}
+	else
+	{
+		glUseProgram(fadeProgram);
+		glUniform1f(decayLocation, decay);
+		quad(fadeProgram, textures[current]);
+	}
+	current = target;
+}
+
+void trailBuffer::end()
+{
+	if (!ready() || width == 0) return;
+	glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(callerFramebuffer));
+	glViewport(callerViewport[0], callerViewport[1], callerViewport[2], callerViewport[3]);
+}
+
+void trailBuffer::compose() const
+{
+	if (!ready() || width == 0) return;
+	quad(composeProgram, textures[current]);
+}
+
+float trailBuffer::decay(const float frames)
+{
+	// e^-4 left after the length of the trail
+	return frames < 1.0F ? 0.0F : std::exp(-4.0F / frames);
+}
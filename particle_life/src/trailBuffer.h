@@ -0,0 +1,74 @@
+#pragma once
+
+/*
+ * Offscreen accumulation of the particle pass, for the trails.
+ * The particles are drawn into one of two textures of the size of the canvas, after the other one, which
+ * holds the previous frames, has been copied into it through the decay shader: every channel is scaled by
+ * the decay and lowered by one step of 8 bits, so that the trails fade out completely instead of leaving
+ * ghosts that rounding would keep at a few units. The result is then composed over the window, which only
+ * holds the latest frame and the interface drawn over it, never past frames.
+ * It needs OpenGL 3.0 or ARB_framebuffer_object, and GLSL 1.20.
+ */
+
+class trailBuffer
+{
+public:
+	/**
+	 * @brief Compile the shaders and create the quad, in the current context
+	 *
+	 * @return false when the context has no framebuffer objects or no GLSL 1.20, the buffer is then not usable
+	 */
+	bool setup();
+
+	// true once setup() succeeded
+	bool ready() const { return fadeProgram != 0; }
+
+	// delete the shaders, the textures and the framebuffers, while the context of setup() is still current
+	void release();
+
+	/**
+	 * @brief Start the particle pass: later draws go to the accumulation instead of the framebuffer of the caller
+	 *
+	 * The accumulation is cleared when its size changes, and faded otherwise.
+	 *
+	 * @param width width of the canvas in pixels
+	 * @param height height of the canvas
+	 * @param decay share of the previous frames that is kept, 0 clears them
+	 */
+	void begin(int width, int height, float decay);
+
+	// end the particle pass, back to the framebuffer and the viewport of the caller
+	void end();
+
+	// copy the accumulation over the whole viewport of the caller, without blending
+	void compose() const;
+
+	/**
+	 * @brief Decay of a trail of the given length
+	 *
+	 * @param frames frames after which a trail is down to 2% of its light, none below 1
+	 */
+	static float decay(float frames);
+
+private:
+	// textures and framebuffers of the size of the canvas, cleared
+	void resize(int width, int height);
+
+	// clear the bound framebuffer to opaque black, keeping the clear color of the caller
+	static void clear();
+
+	// draw the quad over the viewport with one of the programs, from one of the textures
+	void quad(unsigned int program, unsigned int texture) const;
+
+	unsigned int fadeProgram = 0;
+	unsigned int composeProgram = 0;
+	unsigned int corners = 0;			// vertex buffer of the quad
+	unsigned int textures[2] = {};
+	unsigned int framebuffers[2] = {};
+	int current = 0;					// texture that holds the latest frame
+	int width = 0;
+	int height = 0;
+	int decayLocation = -1;
+	int callerFramebuffer = 0;			// state of the caller, saved by begin()
+	int callerViewport[4] = {};
+};
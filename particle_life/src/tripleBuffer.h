@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+
+/*
+ * Lock free triple buffer between one writer and one reader.
+ * The writer fills its back buffer and publishes it, the reader picks up the latest published buffer
+ * when it wants to. Neither of them ever waits for the other: the third buffer is the one in between,
+ * and an unread buffer is simply replaced by a newer one.
+ */
+template <typename T>
+class tripleBuffer
+{
+public:
+	// buffer owned by the writer
+	T& back() { return slots[backIndex]; }
+
+	// hand the back buffer to the reader
+	void publish()
+	{
+		backIndex = middle.exchange(backIndex | fresh, std::memory_order_acq_rel) & index;
+	}
+
+	// take the latest published buffer, if there is a new one since the last call
+	bool update()
+	{
+		if ((middle.load(std::memory_order_acquire) & fresh) == 0) return false;
+		frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & index;
+		return true;
+	}
+
+	// buffer owned by the reader
+	const T& front() const { return slots[frontIndex]; }
+
+	// every buffer, only while neither the writer nor the reader is running
+	T* begin() { return slots; }
+	T* end() { return slots + 3; }
+
+private:
+	static constexpr int index = 3;
+	static constexpr int fresh = 4;
+
+	T slots[3];
+	int backIndex = 0;
+	int frontIndex = 1;
+	std::atomic<int> middle{ 2 };
+};